@@ -0,0 +1,127 @@
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "hidden_context.h"
+#include "particle_system.h"
+#include "thread_pool.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double MillisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// prints the average time per repetition and how many particles that processes per second
+static void PrintThroughput(const char* name, const char* unit, double milliseconds, int repetitions, uint32_t particleCount)
+{
+    double count = repetitions > 0 ? static_cast<double>(repetitions) : 1.0;
+    double particles = static_cast<double>(particleCount) * count;
+
+    std::cout << "    " << name << milliseconds / count << " ms/" << unit << " ("
+              << particles / (milliseconds * 1000.0) << " million particles/s)\n";
+}
+
+// emits particleCount particles in one batch, simulates them for stepCount steps and, on the CPU, sorts them as often.
+// Nothing is drawn
+static bool RunBackend(const char* label, ParticleBackend backend, ThreadPool* threadPool, uint32_t particleCount, int stepCount)
+{
+    ParticleSystemCreateInfo info{};
+    info.backend = backend;
+    info.capacity = particleCount;
+    info.createRenderResources = false;
+    info.threadPool = threadPool;
+    // nothing dies during the run, so every step touches every particle
+    info.lifetime = 1000.0f;
+
+    ParticleSystem particles;
+    if(!particles.Create(info))
+    {
+        std::cout << "  " << label << ": failed to create" << std::endl;
+        return false;
+    }
+
+    std::cout << "  " << label << ":\n";
+
+    // the GPU works asynchronously, so each of its timings only ends once glFinish() returns
+    bool isGpu = backend == ParticleBackend::Gpu;
+
+    Clock::time_point start = Clock::now();
+    particles.Emit(particleCount);
+    if(isGpu)
+    {
+        glFinish();
+    }
+    PrintThroughput("emit:     ", "batch", MillisecondsSince(start), 1, particleCount);
+
+    particles.Simulate(1.0f / 60.0f);
+    if(isGpu)
+    {
+        glFinish();
+    }
+
+    start = Clock::now();
+    for(int step = 0; step < stepCount; step++)
+    {
+        particles.Simulate(1.0f / 60.0f);
+    }
+    if(isGpu)
+    {
+        glFinish();
+    }
+    PrintThroughput("simulate: ", "step", MillisecondsSince(start), stepCount, particleCount);
+
+    // the GPU backend draws unsorted with additive blending, only the CPU backend sorts
+    if(!isGpu)
+    {
+        glm::vec3 cameraPosition(0.0f, 0.0f, 10.0f);
+        glm::vec3 cameraForward(0.0f, 0.0f, -1.0f);
+
+        start = Clock::now();
+        for(int step = 0; step < stepCount; step++)
+        {
+            particles.BuildCpuInstances(cameraPosition, cameraForward);
+        }
+        PrintThroughput("sort:     ", "sort", MillisecondsSince(start), stepCount, particles.GetStats().aliveCount);
+    }
+
+    std::cout << std::flush;
+    particles.Dispose();
+    return true;
+}
+
+// usage: particle-benchmark [particleCount] [stepCount]
+int main(int argc, char** argv)
+{
+    uint32_t particleCount = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 1000000;
+    int stepCount = argc > 2 ? std::atoi(argv[2]) : 100;
+
+    ThreadPool threadPool;
+    threadPool.Create();
+
+    std::cout << "particle benchmark: " << particleCount << " particles, " << stepCount << " steps" << std::endl;
+
+    bool success = RunBackend("cpu, 1 thread", ParticleBackend::Cpu, nullptr, particleCount, stepCount);
+
+    std::string pooledLabel = "cpu, thread pool (" + std::to_string(threadPool.GetWorkerCount() + 1) + " threads)";
+    success = RunBackend(pooledLabel.c_str(), ParticleBackend::Cpu, &threadPool, particleCount, stepCount) && success;
+
+    GLFWwindow* window = CreateHiddenContext("particle-benchmark");
+    if(window != nullptr)
+    {
+        success = RunBackend("gpu", ParticleBackend::Gpu, nullptr, particleCount, stepCount) && success;
+
+        DestroyHiddenContext(window);
+    }
+    else
+    {
+        std::cout << "  gpu: no OpenGL 3.3 context, skipped" << std::endl;
+    }
+
+    threadPool.Dispose();
+    return success ? 0 : 1;
+}
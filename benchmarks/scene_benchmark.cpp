@@ -0,0 +1,106 @@
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "scene.h"
+#include "thread_pool.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double MillisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// usage: scene-benchmark [entityCount] [frameCount]
+int main(int argc, char** argv)
+{
+    size_t entityCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+    int frameCount = argc > 2 ? std::atoi(argv[2]) : 20;
+
+    ThreadPool threadPool;
+    threadPool.Create();
+
+    std::cout << "scene benchmark: " << entityCount << " entities, " << frameCount << " frames, "
+              << threadPool.GetWorkerCount() + 1 << " threads" << std::endl;
+
+    Scene scene;
+    std::vector<Entity> entities;
+    entities.reserve(entityCount);
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> coordinate(-100.0f, 100.0f);
+
+    Clock::time_point start = Clock::now();
+    for(size_t i = 0; i < entityCount; i++)
+    {
+        Entity entity = scene.CreateEntity(ComponentTransform | ComponentRenderable | ComponentAnimation | ComponentBounds);
+        scene.GetTransform(entity)->position = glm::vec3(coordinate(random), coordinate(random), coordinate(random));
+        scene.GetAnimation(entity)->angularSpeed = 20.0f;
+        scene.GetBounds(entity)->radius = 0.87f;
+        entities.push_back(entity);
+    }
+    double createMilliseconds = MillisecondsSince(start);
+
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 150.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 proj = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 300.0f);
+    glm::mat4 viewProj = proj * view;
+
+    double animationMilliseconds = 0.0;
+    double transformMilliseconds = 0.0;
+    double cullMilliseconds = 0.0;
+
+    for(int frame = 0; frame < frameCount; frame++)
+    {
+        float time = frame / 60.0f;
+
+        start = Clock::now();
+        UpdateAnimationSystem(scene, threadPool, time);
+        animationMilliseconds += MillisecondsSince(start);
+
+        start = Clock::now();
+        UpdateTransformSystem(scene, threadPool);
+        transformMilliseconds += MillisecondsSince(start);
+
+        start = Clock::now();
+        UpdateCullSystem(scene, threadPool, viewProj);
+        cullMilliseconds += MillisecondsSince(start);
+    }
+
+    size_t visibleCount = 0;
+    scene.ForEachChunk(ComponentRenderable, [&visibleCount](Chunk& chunk)
+    {
+        for(size_t i = 0; i < chunk.count; i++)
+        {
+            visibleCount += chunk.renderables[i].visible ? 1 : 0;
+        }
+    });
+
+    // destroy in random order so the swap-fill moves rows all over the archetype
+    std::shuffle(entities.begin(), entities.end(), random);
+    start = Clock::now();
+    for(Entity entity : entities)
+    {
+        scene.DestroyEntity(entity);
+    }
+    double destroyMilliseconds = MillisecondsSince(start);
+
+    double frames = frameCount > 0 ? static_cast<double>(frameCount) : 1.0;
+    double millionEntities = static_cast<double>(entityCount) / 1000000.0;
+
+    std::cout << "  create:    " << createMilliseconds << " ms (" << createMilliseconds / millionEntities << " ms per million)\n"
+              << "  animation: " << animationMilliseconds / frames << " ms/frame\n"
+              << "  transform: " << transformMilliseconds / frames << " ms/frame\n"
+              << "  cull:      " << cullMilliseconds / frames << " ms/frame (" << visibleCount << " visible)\n"
+              << "  destroy:   " << destroyMilliseconds << " ms (" << destroyMilliseconds / millionEntities << " ms per million)\n"
+              << "  remaining: " << scene.GetEntityCount() << std::endl;
+
+    threadPool.Dispose();
+    return scene.GetEntityCount() == 0 ? 0 : 1;
+}
@@ -0,0 +1,18 @@
+#version 330
+
+out vec4 FragColor;
+
+in vec2 corner;
+in float life;
+
+void main()
+{
+    float distance = length(corner) * 2.0;
+    if(distance > 1.0)
+    {
+        discard;
+    }
+
+    float alpha = (1.0 - distance) * (1.0 - life);
+    FragColor = vec4(mix(vec3(1.0, 0.8, 0.3), vec3(1.0, 0.2, 0.1), life), alpha);
+}
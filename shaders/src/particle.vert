@@ -0,0 +1,28 @@
+#version 330
+
+layout (location = 0) in vec2 aCorner;
+layout (location = 1) in vec3 aPosition;
+layout (location = 2) in float aAge;
+layout (location = 3) in float aLifetime;
+
+out vec2 corner;
+out float life;
+
+uniform mat4 view;
+uniform mat4 proj;
+uniform float particleSize;
+
+void main()
+{
+    life = aLifetime > 0.0 ? aAge / aLifetime : 1.0;
+
+    // dead particles collapse to a point and produce no fragments
+    float size = life < 1.0 ? particleSize : 0.0;
+
+    vec3 right = vec3(view[0][0], view[1][0], view[2][0]);
+    vec3 up = vec3(view[0][1], view[1][1], view[2][1]);
+    vec3 worldPosition = aPosition + (right * aCorner.x + up * aCorner.y) * size;
+
+    gl_Position = proj * view * vec4(worldPosition, 1.0);
+    corner = aCorner;
+}
@@ -0,0 +1,30 @@
+#version 330
+
+layout (location = 0) in vec3 aPosition;
+layout (location = 1) in float aAge;
+layout (location = 2) in vec3 aVelocity;
+layout (location = 3) in float aLifetime;
+
+out vec3 outPosition;
+out float outAge;
+out vec3 outVelocity;
+out float outLifetime;
+
+uniform float deltaTime;
+uniform vec3 gravityStep;
+
+void main()
+{
+    outPosition = aPosition;
+    outAge = aAge;
+    outVelocity = aVelocity;
+    outLifetime = aLifetime;
+
+    // same order as the CPU backend: velocity first, then position with the new velocity
+    if(aAge < aLifetime)
+    {
+        outVelocity = aVelocity + gravityStep;
+        outPosition = aPosition + outVelocity * deltaTime;
+        outAge = aAge + deltaTime;
+    }
+}
@@ -1,13 +1,40 @@
 #version 330
 
+#define MAX_MATERIALS 16
+#define MAX_TEXTURE_ARRAYS 4
+
 out vec4 FragColor;
 
 in vec2 texCoord;
+flat in int materialId;
+
+// array i is bound to unit i
+uniform sampler2DArray textures[MAX_TEXTURE_ARRAYS];
+// x = base array, y = base layer, z = overlay array, w = overlay layer. Must match maxMaterials in main.cpp
+uniform ivec4 materials[MAX_MATERIALS];
 
-uniform sampler2D texture1;
-uniform sampler2D texture2;
+vec4 SampleLayer(int array, int layer)
+{
+    // GLSL 330 only indexes sampler arrays with constant expressions. materialId is flat per instance,
+    // so every pixel of a quad takes the same branch and the implicit derivatives stay valid
+    vec3 coord = vec3(texCoord, layer);
+    if(array == 1)
+    {
+        return texture(textures[1], coord);
+    }
+    if(array == 2)
+    {
+        return texture(textures[2], coord);
+    }
+    if(array == 3)
+    {
+        return texture(textures[3], coord);
+    }
+    return texture(textures[0], coord);
+}
 
 void main()
 {
-    FragColor = mix(texture(texture1, texCoord), texture(texture2, texCoord), 0.2);
+    ivec4 material = materials[materialId];
+    FragColor = mix(SampleLayer(material.x, material.y), SampleLayer(material.z, material.w), 0.2);
 }
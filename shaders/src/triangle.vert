@@ -2,15 +2,19 @@
 
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aTexCoord;
+// per instance
+layout (location = 2) in mat4 aModel;
+layout (location = 6) in int aMaterialId;
 
 out vec2 texCoord;
+flat out int materialId;
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 proj;
 
 void main()
 {
-    gl_Position = proj * view * model * vec4(aPos, 1.0f);
+    gl_Position = proj * view * aModel * vec4(aPos, 1.0f);
     texCoord = aTexCoord;
+    materialId = aMaterialId;
 }
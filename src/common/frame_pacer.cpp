@@ -0,0 +1,293 @@
+#include "frame_pacer.h"
+
+#include <glfw/glfw3.h>
+
+#ifdef _WIN32
+// glad already defined APIENTRY, let windows.h define it again without a redefinition warning
+#undef APIENTRY
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <mmsystem.h>
+#endif
+
+#include <algorithm>
+#include <thread>
+
+// never hand less than this to the spin loop, OS sleeps routinely overshoot by a fraction of a millisecond
+static const double MIN_SPIN_MILLISECONDS = 0.2;
+// enough for a 1 ms scheduler tick, which Create() requests on Windows where the default tick is about 15.6 ms
+static const double MAX_SPIN_MILLISECONDS = 4.0;
+
+FrameTimeHistogram::FrameTimeHistogram(double bucketMilliseconds, uint32_t bucketCount) : bucketMilliseconds(bucketMilliseconds), buckets(bucketCount + 1, 0)
+{
+}
+
+void FrameTimeHistogram::Add(double milliseconds)
+{
+    size_t bucket = static_cast<size_t>(std::max(milliseconds, 0.0) / bucketMilliseconds);
+    buckets[std::min(bucket, buckets.size() - 1)]++;
+
+    sampleCount++;
+    total += milliseconds;
+    max = std::max(max, milliseconds);
+}
+
+void FrameTimeHistogram::Clear()
+{
+    std::fill(buckets.begin(), buckets.end(), 0);
+    sampleCount = 0;
+    total = 0.0;
+    max = 0.0;
+}
+
+uint64_t FrameTimeHistogram::GetSampleCount() const
+{
+    return sampleCount;
+}
+
+double FrameTimeHistogram::GetAverage() const
+{
+    return sampleCount > 0 ? total / static_cast<double>(sampleCount) : 0.0;
+}
+
+double FrameTimeHistogram::GetMax() const
+{
+    return max;
+}
+
+double FrameTimeHistogram::GetPercentile(double percentile) const
+{
+    if(sampleCount == 0)
+    {
+        return 0.0;
+    }
+
+    uint64_t threshold = static_cast<uint64_t>(static_cast<double>(sampleCount) * percentile / 100.0);
+    uint64_t accumulated = 0;
+
+    for(size_t i = 0; i < buckets.size(); i++)
+    {
+        accumulated += buckets[i];
+        if(accumulated > threshold || accumulated == sampleCount)
+        {
+            // the overflow bucket has no upper edge
+            return i + 1 < buckets.size() ? (i + 1) * bucketMilliseconds : max;
+        }
+    }
+
+    return max;
+}
+
+const std::vector<uint64_t>& FrameTimeHistogram::GetBuckets() const
+{
+    return buckets;
+}
+
+double FrameTimeHistogram::GetBucketMilliseconds() const
+{
+    return bucketMilliseconds;
+}
+
+void FrameTimeHistogram::Print(std::ostream& stream) const
+{
+    stream << "samples " << sampleCount << "  avg " << GetAverage() << " ms  p50 " << GetPercentile(50.0)
+           << " ms  p95 " << GetPercentile(95.0) << " ms  p99 " << GetPercentile(99.0) << " ms  max " << max << " ms\n";
+}
+
+bool FramePacer::Create(const FramePacerCreateInfo& info)
+{
+    SetSwapInterval(info.swapInterval);
+    SetTargetFrameTime(info.targetFrameTime);
+    SetMaxFramesInFlight(info.maxFramesInFlight);
+
+    frameIndex = 0;
+    hasLastFrame = false;
+    ResetStatistics();
+
+#ifdef _WIN32
+    // without this the sleep in WaitUntil() rounds up to the default tick and overshoots the deadline by up to 15 ms
+    if(!raisedTimerResolution)
+    {
+        raisedTimerResolution = timeBeginPeriod(1) == TIMERR_NOERROR;
+    }
+#endif
+
+    return true;
+}
+
+void FramePacer::Dispose()
+{
+    DeleteFences();
+
+#ifdef _WIN32
+    if(raisedTimerResolution)
+    {
+        timeEndPeriod(1);
+        raisedTimerResolution = false;
+    }
+#endif
+}
+
+void FramePacer::DeleteFences()
+{
+    for(GLsync& fence : fences)
+    {
+        if(fence != nullptr)
+        {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+}
+
+void FramePacer::BeginFrame()
+{
+    // Create() has not been called, there is nothing to pace against
+    if(fences.empty())
+    {
+        return;
+    }
+
+    Clock::time_point waitStart = Clock::now();
+
+    // the fence of the frame submitted maxFramesInFlight frames ago
+    WaitForFence(fences[frameIndex % fences.size()]);
+
+    if(targetFrameTime > 0.0 && hasLastFrame)
+    {
+        auto frameDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(targetFrameTime));
+        WaitUntil(lastFrameStart + frameDuration);
+    }
+
+    lastFrameStart = Clock::now();
+    waitTimes.Add(std::chrono::duration<double, std::milli>(lastFrameStart - waitStart).count());
+}
+
+void FramePacer::EndFrame()
+{
+    if(fences.empty())
+    {
+        return;
+    }
+
+    GLsync& fence = fences[frameIndex % fences.size()];
+    if(fence != nullptr)
+    {
+        glDeleteSync(fence);
+    }
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frameIndex++;
+
+    Clock::time_point now = Clock::now();
+    if(hasLastFrame)
+    {
+        frameTimes.Add(std::chrono::duration<double, std::milli>(now - lastFrameEnd).count());
+    }
+
+    lastFrameEnd = now;
+    hasLastFrame = true;
+}
+
+void FramePacer::SetSwapInterval(int interval)
+{
+    swapInterval = interval;
+    glfwSwapInterval(interval);
+}
+
+int FramePacer::GetSwapInterval() const
+{
+    return swapInterval;
+}
+
+void FramePacer::SetTargetFrameTime(double milliseconds)
+{
+    targetFrameTime = std::max(milliseconds, 0.0);
+}
+
+double FramePacer::GetTargetFrameTime() const
+{
+    return targetFrameTime;
+}
+
+void FramePacer::SetMaxFramesInFlight(uint32_t count)
+{
+    DeleteFences();
+
+    fences.assign(std::max(count, 1u), nullptr);
+    frameIndex = 0;
+}
+
+uint32_t FramePacer::GetMaxFramesInFlight() const
+{
+    return static_cast<uint32_t>(fences.size());
+}
+
+const FrameTimeHistogram& FramePacer::GetFrameTimes() const
+{
+    return frameTimes;
+}
+
+const FrameTimeHistogram& FramePacer::GetWaitTimes() const
+{
+    return waitTimes;
+}
+
+void FramePacer::ResetStatistics()
+{
+    frameTimes.Clear();
+    waitTimes.Clear();
+}
+
+void FramePacer::Print(std::ostream& stream) const
+{
+    stream << "FramePacer: swap interval " << swapInterval << ", target " << targetFrameTime << " ms, "
+           << fences.size() << " frames in flight, spin " << spinMilliseconds << " ms\n";
+    stream << "  frame time: ";
+    frameTimes.Print(stream);
+    stream << "  wait time:  ";
+    waitTimes.Print(stream);
+}
+
+void FramePacer::WaitForFence(GLsync& fence)
+{
+    if(fence == nullptr)
+    {
+        return;
+    }
+
+    // flush once so the fence is guaranteed to signal, then keep waiting in 1 ms slices
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    while(glClientWaitSync(fence, flags, 1000000) == GL_TIMEOUT_EXPIRED)
+    {
+        flags = 0;
+    }
+
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void FramePacer::WaitUntil(Clock::time_point deadline)
+{
+    Clock::time_point now = Clock::now();
+    double remaining = std::chrono::duration<double, std::milli>(deadline - now).count();
+
+    // coarse OS sleep for the bulk of the wait, then adapt the hand-over point to how much the sleep overshot
+    double sleepMilliseconds = remaining - spinMilliseconds;
+    if(sleepMilliseconds > 0.0)
+    {
+        Clock::time_point wakeTarget = now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(sleepMilliseconds));
+        std::this_thread::sleep_until(wakeTarget);
+
+        double overshoot = std::chrono::duration<double, std::milli>(Clock::now() - wakeTarget).count();
+        double wanted = std::clamp(overshoot * 1.5, MIN_SPIN_MILLISECONDS, MAX_SPIN_MILLISECONDS);
+        spinMilliseconds = spinMilliseconds * 0.9 + wanted * 0.1;
+        // react immediately to a bad oversleep, relax slowly
+        spinMilliseconds = std::max(spinMilliseconds, wanted);
+    }
+
+    while(Clock::now() < deadline)
+    {
+        std::this_thread::yield();
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Fixed-width bucket histogram of durations in milliseconds. The last bucket collects everything above the range
+class FrameTimeHistogram
+{
+public:
+    FrameTimeHistogram(double bucketMilliseconds = 0.25, uint32_t bucketCount = 200);
+
+    void Add(double milliseconds);
+    void Clear();
+
+    uint64_t GetSampleCount() const;
+    double GetAverage() const;
+    double GetMax() const;
+    // upper edge of the bucket that contains the given percentile (0..100)
+    double GetPercentile(double percentile) const;
+    const std::vector<uint64_t>& GetBuckets() const;
+    double GetBucketMilliseconds() const;
+
+    void Print(std::ostream& stream) const;
+
+private:
+    double bucketMilliseconds;
+    std::vector<uint64_t> buckets;
+    uint64_t sampleCount = 0;
+    double total = 0.0;
+    double max = 0.0;
+};
+
+struct FramePacerCreateInfo
+{
+    // passed to glfwSwapInterval, 0 disables vsync
+    int swapInterval = 1;
+    // minimum time between frame starts in milliseconds, 0 leaves the rate to vsync
+    double targetFrameTime = 0.0;
+    // how many frames the CPU may queue ahead of the GPU before BeginFrame blocks
+    uint32_t maxFramesInFlight = 2;
+};
+
+// Bounds CPU run-ahead with fences and caps the frame rate with a hybrid sleep/spin wait.
+// Call BeginFrame() right before polling input so the frame is simulated with the freshest input, and EndFrame() right after the swap
+class FramePacer
+{
+public:
+    bool Create(const FramePacerCreateInfo& info);
+    void Dispose();
+
+    void BeginFrame();
+    void EndFrame();
+
+    void SetSwapInterval(int interval);
+    int GetSwapInterval() const;
+    void SetTargetFrameTime(double milliseconds);
+    double GetTargetFrameTime() const;
+    void SetMaxFramesInFlight(uint32_t count);
+    uint32_t GetMaxFramesInFlight() const;
+
+    // time between consecutive EndFrame calls
+    const FrameTimeHistogram& GetFrameTimes() const;
+    // time BeginFrame spent blocked on fences and the frame cap
+    const FrameTimeHistogram& GetWaitTimes() const;
+    void ResetStatistics();
+
+    void Print(std::ostream& stream) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void DeleteFences();
+    void WaitForFence(GLsync& fence);
+    void WaitUntil(Clock::time_point deadline);
+
+    int swapInterval = 1;
+    double targetFrameTime = 0.0;
+    std::vector<GLsync> fences;
+    uint64_t frameIndex = 0;
+
+    Clock::time_point lastFrameStart;
+    Clock::time_point lastFrameEnd;
+    bool hasLastFrame = false;
+    // how early the OS sleep hands over to spinning, adapted to the observed oversleep
+    double spinMilliseconds = 1.0;
+    // Windows only, whether Create() raised the scheduler resolution to 1 ms
+    bool raisedTimerResolution = false;
+
+    FrameTimeHistogram frameTimes;
+    FrameTimeHistogram waitTimes;
+};
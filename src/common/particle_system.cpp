@@ -0,0 +1,598 @@
+#include "particle_system.h"
+
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PARTICLES_USE_SSE2
+#endif
+
+// particles handed to one thread pool job by the CPU backend
+static const uint32_t SIMULATE_BLOCK_SIZE = 16384;
+
+static bool CreateParticlePipeline(const std::string& vertexPath, const std::string& fragmentPath, const std::vector<std::string>& varyings, Pipeline& pipeline);
+static uint32_t FromDepthToSortKey(float depth);
+static void RadixSort(std::vector<uint32_t>& keys, std::vector<uint32_t>& values, std::vector<uint32_t>& scratchKeys, std::vector<uint32_t>& scratchValues);
+
+bool ParticleSystem::Create(const ParticleSystemCreateInfo& createInfo)
+{
+    info = createInfo;
+    random.seed(info.seed);
+    emitCursor = 0;
+    emitAccumulator = 0.0f;
+    current = 0;
+    stats = ParticleStats{};
+
+    // age == lifetime == 0 marks a slot as dead
+    std::vector<Particle> initial(info.capacity, Particle{glm::vec3(0.0f), 0.0f, glm::vec3(0.0f), 0.0f});
+
+    if(info.backend == ParticleBackend::Cpu)
+    {
+        positionX.assign(info.capacity, 0.0f);
+        positionY.assign(info.capacity, 0.0f);
+        positionZ.assign(info.capacity, 0.0f);
+        velocityX.assign(info.capacity, 0.0f);
+        velocityY.assign(info.capacity, 0.0f);
+        velocityZ.assign(info.capacity, 0.0f);
+        ages.assign(info.capacity, 0.0f);
+        lifetimes.assign(info.capacity, 0.0f);
+    }
+    else
+    {
+        if(!CreateParticlePipeline("./shaders/particle_update.vert", "", {"outPosition", "outAge", "outVelocity", "outLifetime"}, updatePipeline))
+        {
+            return false;
+        }
+
+        glGenBuffers(2, buffers);
+        glGenVertexArrays(2, updateVaos);
+
+        for(int i = 0; i < 2; i++)
+        {
+            glBindVertexArray(updateVaos[i]);
+            glBindBuffer(GL_ARRAY_BUFFER, buffers[i]);
+            glBufferData(GL_ARRAY_BUFFER, info.capacity * sizeof(Particle), initial.data(), GL_DYNAMIC_COPY);
+
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Particle), reinterpret_cast<void*>(offsetof(Particle, position)));
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(Particle), reinterpret_cast<void*>(offsetof(Particle, age)));
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Particle), reinterpret_cast<void*>(offsetof(Particle, velocity)));
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(Particle), reinterpret_cast<void*>(offsetof(Particle, lifetime)));
+            glEnableVertexAttribArray(3);
+        }
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    hasRenderResources = info.createRenderResources;
+    if(!hasRenderResources)
+    {
+        return true;
+    }
+
+    if(!CreateParticlePipeline("./shaders/particle.vert", "./shaders/particle.frag", {}, renderPipeline))
+    {
+        return false;
+    }
+
+    // one unit quad drawn as a triangle strip, expanded towards the camera in the vertex shader
+    const GLfloat corners[] = {
+        -0.5f, -0.5f,
+         0.5f, -0.5f,
+        -0.5f,  0.5f,
+         0.5f,  0.5f
+    };
+
+    glGenVertexArrays(1, &renderVao);
+    glBindVertexArray(renderVao);
+
+    glGenBuffers(1, &quadBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), static_cast<void*>(0));
+    glEnableVertexAttribArray(0);
+
+    // per-instance attributes, pointed at the right buffer in Draw()
+    for(GLuint attribute = 1; attribute <= 3; attribute++)
+    {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
+
+    if(info.backend == ParticleBackend::Cpu)
+    {
+        glGenBuffers(1, &instanceBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        glBufferData(GL_ARRAY_BUFFER, info.capacity * sizeof(Particle), nullptr, GL_STREAM_DRAW);
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return true;
+}
+
+void ParticleSystem::Dispose()
+{
+    if(buffers[0] != 0)
+    {
+        glDeleteBuffers(2, buffers);
+        glDeleteVertexArrays(2, updateVaos);
+        buffers[0] = buffers[1] = 0;
+        updateVaos[0] = updateVaos[1] = 0;
+    }
+
+    if(hasRenderResources)
+    {
+        glDeleteBuffers(1, &quadBuffer);
+        glDeleteVertexArrays(1, &renderVao);
+        if(instanceBuffer != 0)
+        {
+            glDeleteBuffers(1, &instanceBuffer);
+        }
+
+        quadBuffer = 0;
+        renderVao = 0;
+        instanceBuffer = 0;
+        hasRenderResources = false;
+    }
+
+    updatePipeline.Dispose();
+    renderPipeline.Dispose();
+
+    positionX.clear();
+    positionY.clear();
+    positionZ.clear();
+    velocityX.clear();
+    velocityY.clear();
+    velocityZ.clear();
+    ages.clear();
+    lifetimes.clear();
+    instances.clear();
+}
+
+void ParticleSystem::Emit(uint32_t count)
+{
+    count = std::min(count, info.capacity);
+    if(count == 0)
+    {
+        return;
+    }
+
+    // particles are always generated on the CPU so both backends see the exact same stream for a given seed
+    std::uniform_real_distribution<float> jitter(-1.0f, 1.0f);
+    emitted.resize(count);
+    for(Particle& particle : emitted)
+    {
+        particle.position = info.emitterPosition;
+        particle.velocity = info.initialVelocity + info.velocityJitter * glm::vec3(jitter(random), jitter(random), jitter(random));
+        particle.age = 0.0f;
+        particle.lifetime = info.lifetime;
+    }
+
+    // the ring wraps at most once, so this is at most two contiguous uploads
+    uint32_t firstCount = std::min(count, info.capacity - emitCursor);
+    uint32_t ranges[2][3] = {
+        {emitCursor, 0, firstCount},
+        {0, firstCount, count - firstCount}
+    };
+
+    for(const auto& range : ranges)
+    {
+        if(range[2] == 0)
+        {
+            continue;
+        }
+
+        if(info.backend == ParticleBackend::Cpu)
+        {
+            WriteParticlesCpu(range[0], emitted.data() + range[1], range[2]);
+        }
+        else
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, buffers[current]);
+            glBufferSubData(GL_ARRAY_BUFFER, range[0] * sizeof(Particle), range[2] * sizeof(Particle), emitted.data() + range[1]);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+    }
+
+    emitCursor = (emitCursor + count) % info.capacity;
+}
+
+void ParticleSystem::Update(float deltaTime)
+{
+    emitAccumulator += info.emissionRate * deltaTime;
+    uint32_t count = static_cast<uint32_t>(emitAccumulator);
+    emitAccumulator -= static_cast<float>(count);
+
+    Emit(count);
+    Simulate(deltaTime);
+}
+
+void ParticleSystem::Simulate(float deltaTime)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    if(info.backend == ParticleBackend::Cpu)
+    {
+        SimulateCpu(deltaTime);
+    }
+    else
+    {
+        SimulateGpu(deltaTime);
+    }
+
+    // for the GPU backend this is only the submission cost
+    stats.simulateMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ParticleSystem::Draw(const glm::mat4& view, const glm::mat4& proj, const glm::vec3& cameraPosition, const glm::vec3& cameraForward)
+{
+    if(!hasRenderResources)
+    {
+        return;
+    }
+
+    GLuint sourceBuffer;
+    GLsizei instanceCount;
+
+    if(info.backend == ParticleBackend::Cpu)
+    {
+        BuildCpuInstances(cameraPosition, cameraForward);
+
+        // orphan the previous contents so the upload never waits on last frame's draw
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        glBufferData(GL_ARRAY_BUFFER, info.capacity * sizeof(Particle), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(Particle), instances.data());
+
+        sourceBuffer = instanceBuffer;
+        instanceCount = static_cast<GLsizei>(instances.size());
+    }
+    else
+    {
+        // dead particles are collapsed to zero size in the vertex shader
+        sourceBuffer = buffers[current];
+        instanceCount = static_cast<GLsizei>(info.capacity);
+    }
+
+    if(instanceCount == 0)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return;
+    }
+
+    glBindVertexArray(renderVao);
+    glBindBuffer(GL_ARRAY_BUFFER, sourceBuffer);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Particle), reinterpret_cast<void*>(offsetof(Particle, position)));
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(Particle), reinterpret_cast<void*>(offsetof(Particle, age)));
+    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(Particle), reinterpret_cast<void*>(offsetof(Particle, lifetime)));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    renderPipeline.SetActive();
+    renderPipeline.SetMatrix4x4("view", view);
+    renderPipeline.SetMatrix4x4("proj", proj);
+    renderPipeline.SetFloat("particleSize", info.particleSize);
+
+    // unsorted particles need an order independent blend
+    bool sorted = info.backend == ParticleBackend::Cpu && info.sortForBlending;
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, sorted ? GL_ONE_MINUS_SRC_ALPHA : GL_ONE);
+    glDepthMask(GL_FALSE);
+
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, instanceCount);
+
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+
+    glUseProgram(0);
+    glBindVertexArray(0);
+}
+
+void ParticleSystem::Readback(std::vector<Particle>& particles) const
+{
+    particles.resize(info.capacity);
+
+    if(info.backend == ParticleBackend::Cpu)
+    {
+        for(uint32_t i = 0; i < info.capacity; i++)
+        {
+            particles[i].position = glm::vec3(positionX[i], positionY[i], positionZ[i]);
+            particles[i].age = ages[i];
+            particles[i].velocity = glm::vec3(velocityX[i], velocityY[i], velocityZ[i]);
+            particles[i].lifetime = lifetimes[i];
+        }
+    }
+    else
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, buffers[current]);
+        glGetBufferSubData(GL_ARRAY_BUFFER, 0, info.capacity * sizeof(Particle), particles.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+}
+
+ParticleBackend ParticleSystem::GetBackend() const
+{
+    return info.backend;
+}
+
+uint32_t ParticleSystem::GetCapacity() const
+{
+    return info.capacity;
+}
+
+const ParticleStats& ParticleSystem::GetStats() const
+{
+    return stats;
+}
+
+void ParticleSystem::SimulateCpu(float deltaTime)
+{
+    // same operation order as particle_update.vert: velocity first, then position with the new velocity
+    auto simulateBlock = [this, deltaTime](size_t block)
+    {
+        size_t begin = block * SIMULATE_BLOCK_SIZE;
+        size_t end = std::min(begin + SIMULATE_BLOCK_SIZE, static_cast<size_t>(info.capacity));
+        size_t i = begin;
+
+#ifdef PARTICLES_USE_SSE2
+        const __m128 dt = _mm_set1_ps(deltaTime);
+        const __m128 gravityX = _mm_set1_ps(info.gravity.x * deltaTime);
+        const __m128 gravityY = _mm_set1_ps(info.gravity.y * deltaTime);
+        const __m128 gravityZ = _mm_set1_ps(info.gravity.z * deltaTime);
+
+        for(; i + 4 <= end; i += 4)
+        {
+            __m128 age = _mm_loadu_ps(&ages[i]);
+            __m128 alive = _mm_cmplt_ps(age, _mm_loadu_ps(&lifetimes[i]));
+
+            __m128 vx = _mm_loadu_ps(&velocityX[i]);
+            __m128 vy = _mm_loadu_ps(&velocityY[i]);
+            __m128 vz = _mm_loadu_ps(&velocityZ[i]);
+            __m128 newVx = _mm_add_ps(vx, gravityX);
+            __m128 newVy = _mm_add_ps(vy, gravityY);
+            __m128 newVz = _mm_add_ps(vz, gravityZ);
+
+            __m128 px = _mm_loadu_ps(&positionX[i]);
+            __m128 py = _mm_loadu_ps(&positionY[i]);
+            __m128 pz = _mm_loadu_ps(&positionZ[i]);
+            __m128 newPx = _mm_add_ps(px, _mm_mul_ps(newVx, dt));
+            __m128 newPy = _mm_add_ps(py, _mm_mul_ps(newVy, dt));
+            __m128 newPz = _mm_add_ps(pz, _mm_mul_ps(newVz, dt));
+            __m128 newAge = _mm_add_ps(age, dt);
+
+            // dead lanes keep their old values
+            _mm_storeu_ps(&velocityX[i], _mm_or_ps(_mm_and_ps(alive, newVx), _mm_andnot_ps(alive, vx)));
+            _mm_storeu_ps(&velocityY[i], _mm_or_ps(_mm_and_ps(alive, newVy), _mm_andnot_ps(alive, vy)));
+            _mm_storeu_ps(&velocityZ[i], _mm_or_ps(_mm_and_ps(alive, newVz), _mm_andnot_ps(alive, vz)));
+            _mm_storeu_ps(&positionX[i], _mm_or_ps(_mm_and_ps(alive, newPx), _mm_andnot_ps(alive, px)));
+            _mm_storeu_ps(&positionY[i], _mm_or_ps(_mm_and_ps(alive, newPy), _mm_andnot_ps(alive, py)));
+            _mm_storeu_ps(&positionZ[i], _mm_or_ps(_mm_and_ps(alive, newPz), _mm_andnot_ps(alive, pz)));
+            _mm_storeu_ps(&ages[i], _mm_or_ps(_mm_and_ps(alive, newAge), _mm_andnot_ps(alive, age)));
+        }
+#endif
+
+        glm::vec3 gravityStep = info.gravity * deltaTime;
+        for(; i < end; i++)
+        {
+            if(ages[i] >= lifetimes[i])
+            {
+                continue;
+            }
+
+            velocityX[i] += gravityStep.x;
+            velocityY[i] += gravityStep.y;
+            velocityZ[i] += gravityStep.z;
+            positionX[i] += velocityX[i] * deltaTime;
+            positionY[i] += velocityY[i] * deltaTime;
+            positionZ[i] += velocityZ[i] * deltaTime;
+            ages[i] += deltaTime;
+        }
+    };
+
+    size_t blockCount = (info.capacity + SIMULATE_BLOCK_SIZE - 1) / SIMULATE_BLOCK_SIZE;
+    if(info.threadPool != nullptr)
+    {
+        info.threadPool->ParallelFor(blockCount, simulateBlock);
+    }
+    else
+    {
+        for(size_t block = 0; block < blockCount; block++)
+        {
+            simulateBlock(block);
+        }
+    }
+}
+
+void ParticleSystem::SimulateGpu(float deltaTime)
+{
+    updatePipeline.SetActive();
+    updatePipeline.SetFloat("deltaTime", deltaTime);
+    updatePipeline.SetVector3("gravityStep", info.gravity * deltaTime);
+
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindVertexArray(updateVaos[current]);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffers[1 - current]);
+
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(info.capacity));
+    glEndTransformFeedback();
+
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glBindVertexArray(0);
+    glDisable(GL_RASTERIZER_DISCARD);
+    glUseProgram(0);
+
+    current = 1 - current;
+}
+
+void ParticleSystem::WriteParticlesCpu(uint32_t first, const Particle* particles, uint32_t count)
+{
+    for(uint32_t i = 0; i < count; i++)
+    {
+        const Particle& particle = particles[i];
+        uint32_t slot = first + i;
+
+        positionX[slot] = particle.position.x;
+        positionY[slot] = particle.position.y;
+        positionZ[slot] = particle.position.z;
+        velocityX[slot] = particle.velocity.x;
+        velocityY[slot] = particle.velocity.y;
+        velocityZ[slot] = particle.velocity.z;
+        ages[slot] = particle.age;
+        lifetimes[slot] = particle.lifetime;
+    }
+}
+
+void ParticleSystem::BuildCpuInstances(const glm::vec3& cameraPosition, const glm::vec3& cameraForward)
+{
+    if(info.backend != ParticleBackend::Cpu)
+    {
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    sortKeys.clear();
+    sortIndices.clear();
+
+    for(uint32_t i = 0; i < info.capacity; i++)
+    {
+        if(ages[i] >= lifetimes[i])
+        {
+            continue;
+        }
+
+        float depth = (positionX[i] - cameraPosition.x) * cameraForward.x +
+                      (positionY[i] - cameraPosition.y) * cameraForward.y +
+                      (positionZ[i] - cameraPosition.z) * cameraForward.z;
+
+        // inverted so an ascending sort yields back to front
+        sortKeys.push_back(~FromDepthToSortKey(depth));
+        sortIndices.push_back(i);
+    }
+
+    if(info.sortForBlending)
+    {
+        RadixSort(sortKeys, sortIndices, sortScratchKeys, sortScratchIndices);
+    }
+
+    instances.resize(sortIndices.size());
+
+    auto gatherBlock = [this](size_t block)
+    {
+        size_t begin = block * SIMULATE_BLOCK_SIZE;
+        size_t end = std::min(begin + SIMULATE_BLOCK_SIZE, instances.size());
+
+        for(size_t i = begin; i < end; i++)
+        {
+            uint32_t index = sortIndices[i];
+            instances[i].position = glm::vec3(positionX[index], positionY[index], positionZ[index]);
+            instances[i].age = ages[index];
+            instances[i].velocity = glm::vec3(velocityX[index], velocityY[index], velocityZ[index]);
+            instances[i].lifetime = lifetimes[index];
+        }
+    };
+
+    size_t blockCount = (instances.size() + SIMULATE_BLOCK_SIZE - 1) / SIMULATE_BLOCK_SIZE;
+    if(info.threadPool != nullptr)
+    {
+        info.threadPool->ParallelFor(blockCount, gatherBlock);
+    }
+    else
+    {
+        for(size_t block = 0; block < blockCount; block++)
+        {
+            gatherBlock(block);
+        }
+    }
+
+    stats.aliveCount = static_cast<uint32_t>(instances.size());
+    stats.sortMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool CreateParticlePipeline(const std::string& vertexPath, const std::string& fragmentPath, const std::vector<std::string>& varyings, Pipeline& pipeline)
+{
+    ShaderCreateInfo vertexShaderInfo{};
+    vertexShaderInfo.type = ShaderType::Vertex;
+    vertexShaderInfo.path = vertexPath;
+
+    Shader vertexShader{};
+    if(!vertexShader.Create(vertexShaderInfo))
+    {
+        return false;
+    }
+
+    // transform feedback programs have no fragment stage
+    Shader fragmentShader{};
+    if(!fragmentPath.empty())
+    {
+        ShaderCreateInfo fragmentShaderInfo{};
+        fragmentShaderInfo.type = ShaderType::Fragment;
+        fragmentShaderInfo.path = fragmentPath;
+
+        if(!fragmentShader.Create(fragmentShaderInfo))
+        {
+            vertexShader.Dispose();
+            return false;
+        }
+    }
+
+    PipelineCreateInfo pipelineCreateInfo{vertexShader, fragmentShader, varyings};
+    bool success = pipeline.Create(pipelineCreateInfo);
+
+    vertexShader.Dispose();
+    fragmentShader.Dispose();
+
+    return success;
+}
+
+static uint32_t FromDepthToSortKey(float depth)
+{
+    // flip the sign bit for positives and every bit for negatives so the unsigned order matches the float order
+    uint32_t bits;
+    std::memcpy(&bits, &depth, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+static void RadixSort(std::vector<uint32_t>& keys, std::vector<uint32_t>& values, std::vector<uint32_t>& scratchKeys, std::vector<uint32_t>& scratchValues)
+{
+    // least significant digit first, 8 bits per pass; four passes leave the result back in keys/values
+    scratchKeys.resize(keys.size());
+    scratchValues.resize(values.size());
+
+    for(uint32_t shift = 0; shift < 32; shift += 8)
+    {
+        size_t offsets[256] = {};
+        for(uint32_t key : keys)
+        {
+            offsets[(key >> shift) & 0xFF]++;
+        }
+
+        size_t total = 0;
+        for(size_t& offset : offsets)
+        {
+            size_t count = offset;
+            offset = total;
+            total += count;
+        }
+
+        for(size_t i = 0; i < keys.size(); i++)
+        {
+            size_t destination = offsets[(keys[i] >> shift) & 0xFF]++;
+            scratchKeys[destination] = keys[i];
+            scratchValues[destination] = values[i];
+        }
+
+        keys.swap(scratchKeys);
+        values.swap(scratchValues);
+    }
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "pipeline.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+class ThreadPool;
+
+enum class ParticleBackend
+{
+    Gpu,
+    Cpu
+};
+
+// Interleaved layout shared by the GPU buffers, the transform feedback varyings and Readback()
+struct Particle
+{
+    glm::vec3 position;
+    float age;
+    glm::vec3 velocity;
+    float lifetime;
+};
+
+struct ParticleSystemCreateInfo
+{
+    ParticleBackend backend = ParticleBackend::Gpu;
+    uint32_t capacity = 100000;
+    // the CPU backend runs without a GL context when this is false
+    bool createRenderResources = true;
+    // required by the CPU backend, nullptr runs it on the calling thread
+    ThreadPool* threadPool = nullptr;
+    uint32_t seed = 1;
+
+    // particles per second spawned by Update()
+    float emissionRate = 10000.0f;
+    glm::vec3 emitterPosition{0.0f};
+    glm::vec3 initialVelocity{0.0f, 4.0f, 0.0f};
+    float velocityJitter = 1.0f;
+    float lifetime = 2.0f;
+    glm::vec3 gravity{0.0f, -9.81f, 0.0f};
+
+    float particleSize = 0.05f;
+    // CPU backend only: draw back to front with regular alpha blending instead of additive blending
+    bool sortForBlending = true;
+};
+
+struct ParticleStats
+{
+    // CPU backend only, the GPU backend never reads its particles back
+    uint32_t aliveCount = 0;
+    double simulateMilliseconds = 0.0;
+    double sortMilliseconds = 0.0;
+};
+
+// Fixed-capacity particle pool that emits into a ring and draws every particle as an instanced billboard.
+// The GPU backend simulates with transform feedback between two ping-pong buffers, the CPU backend with SSE over the thread pool.
+// Both consume the same emission stream for the same seed, so Readback() of either backend can be compared
+class ParticleSystem
+{
+public:
+    bool Create(const ParticleSystemCreateInfo& info);
+    void Dispose();
+
+    // spawns count particles in one batch, overwriting the oldest ones
+    void Emit(uint32_t count);
+    // emits emissionRate * deltaTime particles, then advances the simulation
+    void Update(float deltaTime);
+    void Simulate(float deltaTime);
+    void Draw(const glm::mat4& view, const glm::mat4& proj, const glm::vec3& cameraPosition, const glm::vec3& cameraForward);
+    // CPU backend only: compacts the live particles and, with sortForBlending, sorts them back to front.
+    // Draw() calls it, it is public so the sort can be measured without rendering
+    void BuildCpuInstances(const glm::vec3& cameraPosition, const glm::vec3& cameraForward);
+
+    void Readback(std::vector<Particle>& particles) const;
+
+    ParticleBackend GetBackend() const;
+    uint32_t GetCapacity() const;
+    const ParticleStats& GetStats() const;
+
+private:
+    void SimulateCpu(float deltaTime);
+    void SimulateGpu(float deltaTime);
+    void WriteParticlesCpu(uint32_t first, const Particle* particles, uint32_t count);
+
+    ParticleSystemCreateInfo info;
+    std::mt19937 random;
+    uint32_t emitCursor = 0;
+    float emitAccumulator = 0.0f;
+    ParticleStats stats;
+    std::vector<Particle> emitted;
+
+    // CPU backend, structure of arrays so the update loop maps onto SIMD lanes
+    std::vector<float> positionX;
+    std::vector<float> positionY;
+    std::vector<float> positionZ;
+    std::vector<float> velocityX;
+    std::vector<float> velocityY;
+    std::vector<float> velocityZ;
+    std::vector<float> ages;
+    std::vector<float> lifetimes;
+    std::vector<Particle> instances;
+    std::vector<uint32_t> sortKeys;
+    std::vector<uint32_t> sortIndices;
+    std::vector<uint32_t> sortScratchKeys;
+    std::vector<uint32_t> sortScratchIndices;
+
+    // GPU backend
+    GLuint buffers[2] = {0, 0};
+    GLuint updateVaos[2] = {0, 0};
+    uint32_t current = 0;
+    Pipeline updatePipeline{};
+
+    // rendering, shared by both backends
+    GLuint quadBuffer = 0;
+    GLuint instanceBuffer = 0;
+    GLuint renderVao = 0;
+    Pipeline renderPipeline{};
+    bool hasRenderResources = false;
+};
@@ -69,7 +69,21 @@ bool Pipeline::Create(const PipelineCreateInfo& info)
 {
     id = glCreateProgram();
     glAttachShader(id, info.vertexShader.GetId());
-    glAttachShader(id, info.fragmentShader.GetId());
+    if(info.fragmentShader.IsValid())
+    {
+        glAttachShader(id, info.fragmentShader.GetId());
+    }
+
+    if(!info.transformFeedbackVaryings.empty())
+    {
+        std::vector<const char*> varyings;
+        for(const std::string& varying : info.transformFeedbackVaryings)
+        {
+            varyings.push_back(varying.c_str());
+        }
+
+        glTransformFeedbackVaryings(id, static_cast<GLsizei>(varyings.size()), varyings.data(), GL_INTERLEAVED_ATTRIBS);
+    }
 
     glLinkProgram(id);
 
@@ -97,6 +111,7 @@ void Pipeline::Dispose()
         return;
     }
 
+    glDeleteProgram(id);
     id = 0;
 }
 
@@ -130,11 +145,26 @@ void Pipeline::SetFloat(const std::string& name, float value) const
     glUniform1f(glGetUniformLocation(id, name.c_str()), value);
 }
 
+void Pipeline::SetVector3(const std::string& name, const glm::vec3& value) const
+{
+    glUniform3fv(glGetUniformLocation(id, name.c_str()), 1, glm::value_ptr(value));
+}
+
 void Pipeline::SetMatrix4x4(const std::string& name, const glm::mat4& value) const
 {
     glUniformMatrix4fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
 }
 
+void Pipeline::SetIntVector4Array(const std::string& name, const glm::ivec4* values, GLsizei count) const
+{
+    if(count <= 0)
+    {
+        return;
+    }
+
+    glUniform4iv(glGetUniformLocation(id, name.c_str()), count, glm::value_ptr(values[0]));
+}
+
 GLenum FromShaderTypeToEnum(ShaderType type)
 {
     switch(type)
@@ -2,8 +2,11 @@
 
 #include <glad/glad.h>
 #include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
 
 #include <string>
+#include <vector>
 
 enum class ShaderType
 {
@@ -33,7 +36,10 @@ private:
 struct PipelineCreateInfo
 {
     Shader& vertexShader;
+    // may be left invalid for transform feedback only programs
     Shader& fragmentShader;
+    // captured interleaved into a single transform feedback buffer when not empty
+    std::vector<std::string> transformFeedbackVaryings{};
 };
 
 class Pipeline
@@ -49,7 +55,9 @@ public:
     void SetBool(const std::string& name, bool value) const;
     void SetInt(const std::string& name, int value) const;
     void SetFloat(const std::string& name, float value) const;
+    void SetVector3(const std::string& name, const glm::vec3& value) const;
     void SetMatrix4x4(const std::string& name, const glm::mat4& value) const;
+    void SetIntVector4Array(const std::string& name, const glm::ivec4* values, GLsizei count) const;
 
 private:
     GLuint id;
@@ -0,0 +1,736 @@
+#include "render_graph.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+static bool IsDepthFormat(TextureFormat format);
+static GLenum FromTextureFormatToInternalFormat(TextureFormat format);
+static GLenum FromTextureFormatToFormat(TextureFormat format);
+static GLenum FromTextureFormatToType(TextureFormat format);
+static const char* FromTextureFormatToString(TextureFormat format);
+
+bool operator==(const TextureDesc& lhs, const TextureDesc& rhs)
+{
+    return lhs.width == rhs.width && lhs.height == rhs.height && lhs.format == rhs.format;
+}
+
+RenderPassContext::RenderPassContext(const RenderGraph& graph) : graph(graph)
+{
+}
+
+GLuint RenderPassContext::GetTexture(ResourceHandle resource) const
+{
+    return graph.GetTexture(resource);
+}
+
+void RenderGraph::Reset()
+{
+    for(PhysicalTexture& physical : physicalTextures)
+    {
+        if(physical.texture != 0)
+        {
+            texturePool.push_back(physical);
+        }
+    }
+
+    resources.clear();
+    passes.clear();
+    executionOrder.clear();
+    physicalTextures.clear();
+    compiled = false;
+}
+
+void RenderGraph::Dispose()
+{
+    Reset();
+
+    for(PhysicalTexture& physical : texturePool)
+    {
+        glDeleteTextures(1, &physical.texture);
+    }
+    texturePool.clear();
+
+    if(framebuffer != 0)
+    {
+        glDeleteFramebuffers(1, &framebuffer);
+        framebuffer = 0;
+    }
+    attachedColorCount = 0;
+    attachedDepth = false;
+
+    for(auto& entry : timers)
+    {
+        glDeleteQueries(2, entry.second.queries);
+    }
+    timers.clear();
+    timings.clear();
+}
+
+ResourceHandle RenderGraph::CreateTexture(const std::string& name, const TextureDesc& desc)
+{
+    Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+
+    resources.push_back(resource);
+    compiled = false;
+    return static_cast<ResourceHandle>(resources.size() - 1);
+}
+
+ResourceHandle RenderGraph::ImportTexture(const std::string& name, GLuint texture, const TextureDesc& desc)
+{
+    ResourceHandle handle = CreateTexture(name, desc);
+    resources[handle].imported = true;
+    resources[handle].texture = texture;
+    return handle;
+}
+
+ResourceHandle RenderGraph::ImportFramebuffer(const std::string& name, GLuint framebuffer, int width, int height)
+{
+    ResourceHandle handle = CreateTexture(name, TextureDesc{width, height, TextureFormat::RGBA8});
+    resources[handle].imported = true;
+    resources[handle].isFramebuffer = true;
+    resources[handle].framebuffer = framebuffer;
+    return handle;
+}
+
+PassHandle RenderGraph::AddPass(const std::string& name, std::function<void(RenderPassContext&)> execute)
+{
+    Pass pass;
+    pass.name = name;
+    pass.execute = std::move(execute);
+
+    passes.push_back(std::move(pass));
+    compiled = false;
+    return static_cast<PassHandle>(passes.size() - 1);
+}
+
+void RenderGraph::Read(PassHandle pass, ResourceHandle resource)
+{
+    passes[pass].reads.push_back(resource);
+    compiled = false;
+}
+
+void RenderGraph::Write(PassHandle pass, ResourceHandle resource)
+{
+    passes[pass].writes.push_back(resource);
+    compiled = false;
+}
+
+void RenderGraph::MarkOutput(ResourceHandle resource)
+{
+    resources[resource].output = true;
+    compiled = false;
+}
+
+bool RenderGraph::Compile()
+{
+    // return the previous build's textures before handing out new slots
+    for(PhysicalTexture& physical : physicalTextures)
+    {
+        if(physical.texture != 0)
+        {
+            texturePool.push_back(physical);
+        }
+    }
+    physicalTextures.clear();
+
+    for(Resource& resource : resources)
+    {
+        resource.firstUse = INVALID_HANDLE;
+        resource.lastUse = INVALID_HANDLE;
+        resource.physical = INVALID_HANDLE;
+    }
+
+    if(!ValidatePasses())
+    {
+        executionOrder.clear();
+        compiled = false;
+        return false;
+    }
+
+    CullPasses();
+
+    if(!SortPasses())
+    {
+        executionOrder.clear();
+        compiled = false;
+        return false;
+    }
+
+    AssignPhysicalTextures();
+
+    compiled = true;
+    return true;
+}
+
+void RenderGraph::Execute()
+{
+    if(!compiled)
+    {
+        return;
+    }
+
+    for(PhysicalTexture& physical : physicalTextures)
+    {
+        if(physical.texture != 0)
+        {
+            continue;
+        }
+
+        auto pooled = std::find_if(texturePool.begin(), texturePool.end(), [&physical](const PhysicalTexture& candidate)
+        {
+            return candidate.desc == physical.desc;
+        });
+
+        if(pooled != texturePool.end())
+        {
+            physical.texture = pooled->texture;
+            texturePool.erase(pooled);
+            continue;
+        }
+
+        glGenTextures(1, &physical.texture);
+        glBindTexture(GL_TEXTURE_2D, physical.texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, FromTextureFormatToInternalFormat(physical.desc.format), physical.desc.width, physical.desc.height, 0,
+                     FromTextureFormatToFormat(physical.desc.format), FromTextureFormatToType(physical.desc.format), nullptr);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    // whatever this build did not claim is stale, e.g. textures of the size before a resize, so free it now
+    for(PhysicalTexture& pooled : texturePool)
+    {
+        glDeleteTextures(1, &pooled.texture);
+    }
+    texturePool.clear();
+
+    // queries are double buffered so reading last frame's result never stalls the pipeline
+    frameIndex++;
+    uint32_t slot = frameIndex % 2;
+
+    RenderPassContext context(*this);
+
+    for(PassHandle passHandle : executionOrder)
+    {
+        const Pass& pass = passes[passHandle];
+
+        PassTimer& timer = timers[pass.name];
+        if(timer.queries[0] == 0)
+        {
+            glGenQueries(2, timer.queries);
+        }
+
+        PassTiming& timing = timings[pass.name];
+        if(timer.pending[slot])
+        {
+            GLint available = 0;
+            glGetQueryObjectiv(timer.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+            if(available)
+            {
+                GLuint64 elapsed = 0;
+                glGetQueryObjectui64v(timer.queries[slot], GL_QUERY_RESULT, &elapsed);
+                timing.gpuMilliseconds = static_cast<double>(elapsed) / 1000000.0;
+            }
+        }
+
+        auto cpuStart = std::chrono::steady_clock::now();
+
+        if(!BindOutputs(pass))
+        {
+            continue;
+        }
+
+        glBeginQuery(GL_TIME_ELAPSED, timer.queries[slot]);
+        pass.execute(context);
+        glEndQuery(GL_TIME_ELAPSED);
+        timer.pending[slot] = true;
+
+        timing.cpuMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cpuStart).count();
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+bool RenderGraph::IsPassCulled(PassHandle pass) const
+{
+    return passes[pass].culled;
+}
+
+const std::vector<PassHandle>& RenderGraph::GetExecutionOrder() const
+{
+    return executionOrder;
+}
+
+uint32_t RenderGraph::GetPhysicalIndex(ResourceHandle resource) const
+{
+    return resources[resource].physical;
+}
+
+uint32_t RenderGraph::GetPhysicalCount() const
+{
+    return static_cast<uint32_t>(physicalTextures.size());
+}
+
+const std::map<std::string, PassTiming>& RenderGraph::GetTimings() const
+{
+    return timings;
+}
+
+void RenderGraph::Dump(std::ostream& stream) const
+{
+    size_t transientCount = 0;
+    for(const Resource& resource : resources)
+    {
+        if(!resource.imported && resource.physical != INVALID_HANDLE)
+        {
+            transientCount++;
+        }
+    }
+
+    stream << "RenderGraph: " << executionOrder.size() << "/" << passes.size() << " passes, "
+           << transientCount << " transient textures on " << physicalTextures.size() << " physical textures\n";
+
+    for(size_t i = 0; i < executionOrder.size(); i++)
+    {
+        const Pass& pass = passes[executionOrder[i]];
+        stream << "  [" << i << "] " << pass.name << "  reads:";
+        for(ResourceHandle read : pass.reads)
+        {
+            stream << " " << resources[read].name;
+        }
+        stream << "  writes:";
+        for(ResourceHandle write : pass.writes)
+        {
+            stream << " " << resources[write].name;
+        }
+
+        auto timing = timings.find(pass.name);
+        if(timing != timings.end())
+        {
+            stream << "  cpu " << timing->second.cpuMilliseconds << " ms  gpu " << timing->second.gpuMilliseconds << " ms";
+        }
+        stream << "\n";
+    }
+
+    for(const Pass& pass : passes)
+    {
+        if(pass.culled)
+        {
+            stream << "  culled: " << pass.name << "\n";
+        }
+    }
+
+    for(const Resource& resource : resources)
+    {
+        stream << "  " << resource.name << " " << resource.desc.width << "x" << resource.desc.height;
+        if(resource.isFramebuffer)
+        {
+            stream << " framebuffer " << resource.framebuffer << " (imported)\n";
+            continue;
+        }
+
+        stream << " " << FromTextureFormatToString(resource.desc.format);
+        if(resource.imported)
+        {
+            stream << " (imported)\n";
+        }
+        else if(resource.physical == INVALID_HANDLE)
+        {
+            stream << " (unused)\n";
+        }
+        else
+        {
+            stream << " -> physical " << resource.physical << " [" << resource.firstUse << ".." << resource.lastUse << "]\n";
+        }
+    }
+}
+
+bool RenderGraph::ValidatePasses() const
+{
+    // an imported framebuffer comes with its own attachments, so a pass writing it cannot attach anything else
+    for(const Pass& pass : passes)
+    {
+        size_t framebufferWrites = std::count_if(pass.writes.begin(), pass.writes.end(), [this](ResourceHandle write)
+        {
+            return resources[write].isFramebuffer;
+        });
+
+        if(framebufferWrites != 0 && pass.writes.size() != 1)
+        {
+            std::cout << "ERROR::RENDER_GRAPH::FRAMEBUFFER_MIXED_WITH_OTHER_WRITES " << pass.name << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void RenderGraph::CullPasses()
+{
+    // a pass survives if it writes something that is imported, marked as output or read by a surviving pass
+    std::vector<bool> needed(resources.size(), false);
+    for(size_t i = 0; i < resources.size(); i++)
+    {
+        needed[i] = resources[i].imported || resources[i].output;
+    }
+
+    for(Pass& pass : passes)
+    {
+        pass.culled = true;
+    }
+
+    bool changed = true;
+    while(changed)
+    {
+        changed = false;
+
+        for(Pass& pass : passes)
+        {
+            if(!pass.culled)
+            {
+                continue;
+            }
+
+            bool writesNeeded = std::any_of(pass.writes.begin(), pass.writes.end(), [&needed](ResourceHandle write) { return needed[write]; });
+            if(!writesNeeded)
+            {
+                continue;
+            }
+
+            pass.culled = false;
+            changed = true;
+
+            for(ResourceHandle read : pass.reads)
+            {
+                needed[read] = true;
+            }
+        }
+    }
+}
+
+bool RenderGraph::SortPasses()
+{
+    // declaration order defines the data flow: a read sees the last writer declared before it, and a write waits for
+    // that writer and for every pass that read the previous contents (so feedback like read history -> write history works)
+    std::vector<std::vector<PassHandle>> dependents(passes.size());
+    std::vector<uint32_t> dependencyCount(passes.size(), 0);
+
+    auto addEdge = [&](PassHandle from, PassHandle to)
+    {
+        if(from == INVALID_HANDLE || from == to || std::find(dependents[from].begin(), dependents[from].end(), to) != dependents[from].end())
+        {
+            return;
+        }
+
+        dependents[from].push_back(to);
+        dependencyCount[to]++;
+    };
+
+    std::vector<PassHandle> lastWriter(resources.size(), INVALID_HANDLE);
+    std::vector<std::vector<PassHandle>> readersSinceWrite(resources.size());
+
+    for(PassHandle i = 0; i < passes.size(); i++)
+    {
+        const Pass& pass = passes[i];
+        if(pass.culled)
+        {
+            continue;
+        }
+
+        for(ResourceHandle read : pass.reads)
+        {
+            addEdge(lastWriter[read], i);
+        }
+
+        for(ResourceHandle write : pass.writes)
+        {
+            addEdge(lastWriter[write], i);
+            for(PassHandle reader : readersSinceWrite[write])
+            {
+                addEdge(reader, i);
+            }
+        }
+
+        for(ResourceHandle read : pass.reads)
+        {
+            readersSinceWrite[read].push_back(i);
+        }
+
+        for(ResourceHandle write : pass.writes)
+        {
+            lastWriter[write] = i;
+            readersSinceWrite[write].clear();
+        }
+    }
+
+    // Kahn's algorithm, preferring the earliest declared pass so independent passes keep their order
+    executionOrder.clear();
+    std::vector<PassHandle> ready;
+    size_t aliveCount = 0;
+    for(PassHandle i = 0; i < passes.size(); i++)
+    {
+        if(!passes[i].culled)
+        {
+            aliveCount++;
+            if(dependencyCount[i] == 0)
+            {
+                ready.push_back(i);
+            }
+        }
+    }
+
+    while(!ready.empty())
+    {
+        auto next = std::min_element(ready.begin(), ready.end());
+        PassHandle pass = *next;
+        ready.erase(next);
+        executionOrder.push_back(pass);
+
+        for(PassHandle dependent : dependents[pass])
+        {
+            dependencyCount[dependent]--;
+            if(dependencyCount[dependent] == 0)
+            {
+                ready.push_back(dependent);
+            }
+        }
+    }
+
+    // edges only ever point from earlier to later declared passes, so this is an internal consistency check
+    if(executionOrder.size() != aliveCount)
+    {
+        std::cout << "ERROR::RENDER_GRAPH::CYCLE_DETECTED" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+void RenderGraph::AssignPhysicalTextures()
+{
+    for(uint32_t position = 0; position < executionOrder.size(); position++)
+    {
+        const Pass& pass = passes[executionOrder[position]];
+
+        auto touch = [&](ResourceHandle handle)
+        {
+            Resource& resource = resources[handle];
+            if(resource.firstUse == INVALID_HANDLE)
+            {
+                resource.firstUse = position;
+            }
+            resource.lastUse = position;
+        };
+
+        std::for_each(pass.reads.begin(), pass.reads.end(), touch);
+        std::for_each(pass.writes.begin(), pass.writes.end(), touch);
+    }
+
+    // outputs are read after the frame, so no other transient may reuse their memory
+    for(Resource& resource : resources)
+    {
+        if(resource.output && resource.firstUse != INVALID_HANDLE)
+        {
+            resource.lastUse = static_cast<uint32_t>(executionOrder.size());
+        }
+    }
+
+    std::vector<ResourceHandle> transients;
+    for(ResourceHandle i = 0; i < resources.size(); i++)
+    {
+        if(!resources[i].imported && resources[i].firstUse != INVALID_HANDLE)
+        {
+            transients.push_back(i);
+        }
+    }
+
+    std::stable_sort(transients.begin(), transients.end(), [this](ResourceHandle lhs, ResourceHandle rhs)
+    {
+        return resources[lhs].firstUse < resources[rhs].firstUse;
+    });
+
+    // greedy interval packing: reuse the first compatible texture whose previous owner is already dead
+    std::vector<uint32_t> physicalLastUse;
+    for(ResourceHandle handle : transients)
+    {
+        Resource& resource = resources[handle];
+
+        for(uint32_t i = 0; i < physicalTextures.size(); i++)
+        {
+            if(physicalTextures[i].desc == resource.desc && physicalLastUse[i] < resource.firstUse)
+            {
+                resource.physical = i;
+                break;
+            }
+        }
+
+        if(resource.physical == INVALID_HANDLE)
+        {
+            PhysicalTexture physical;
+            physical.desc = resource.desc;
+            physicalTextures.push_back(physical);
+            physicalLastUse.push_back(0);
+            resource.physical = static_cast<uint32_t>(physicalTextures.size() - 1);
+        }
+
+        physicalLastUse[resource.physical] = resource.lastUse;
+    }
+}
+
+bool RenderGraph::BindOutputs(const Pass& pass)
+{
+    // Compile() guarantees a framebuffer write is the pass's only write
+    if(pass.writes.size() == 1 && resources[pass.writes[0]].isFramebuffer)
+    {
+        const Resource& resource = resources[pass.writes[0]];
+        glBindFramebuffer(GL_FRAMEBUFFER, resource.framebuffer);
+        glViewport(0, 0, resource.desc.width, resource.desc.height);
+        return true;
+    }
+
+    if(framebuffer == 0)
+    {
+        glGenFramebuffers(1, &framebuffer);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+    std::vector<GLenum> drawBuffers;
+    bool hasDepth = false;
+    const TextureDesc* viewportDesc = nullptr;
+
+    for(ResourceHandle write : pass.writes)
+    {
+        const Resource& resource = resources[write];
+        GLuint texture = GetTexture(write);
+
+        if(IsDepthFormat(resource.desc.format))
+        {
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, texture, 0);
+            hasDepth = true;
+        }
+        else
+        {
+            GLenum attachment = GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(drawBuffers.size());
+            glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, texture, 0);
+            drawBuffers.push_back(attachment);
+        }
+
+        if(viewportDesc == nullptr)
+        {
+            viewportDesc = &resource.desc;
+        }
+    }
+
+    // drop whatever the previous pass left attached
+    for(uint32_t i = static_cast<uint32_t>(drawBuffers.size()); i < attachedColorCount; i++)
+    {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, 0, 0);
+    }
+    if(attachedDepth && !hasDepth)
+    {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+    }
+    attachedColorCount = static_cast<uint32_t>(drawBuffers.size());
+    attachedDepth = hasDepth;
+
+    if(drawBuffers.empty())
+    {
+        glDrawBuffer(GL_NONE);
+    }
+    else
+    {
+        glDrawBuffers(static_cast<GLsizei>(drawBuffers.size()), drawBuffers.data());
+    }
+
+    // e.g. no attachments at all, an imported texture that was never created or attachments of different sizes
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if(status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cout << "ERROR::RENDER_GRAPH::FRAMEBUFFER_INCOMPLETE " << pass.name << " 0x" << std::hex << status << std::dec << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        return false;
+    }
+
+    glViewport(0, 0, viewportDesc->width, viewportDesc->height);
+    return true;
+}
+
+GLuint RenderGraph::GetTexture(ResourceHandle resource) const
+{
+    const Resource& entry = resources[resource];
+    if(entry.imported)
+    {
+        return entry.texture;
+    }
+
+    return entry.physical != INVALID_HANDLE ? physicalTextures[entry.physical].texture : 0;
+}
+
+static bool IsDepthFormat(TextureFormat format)
+{
+    return format == TextureFormat::Depth24Stencil8;
+}
+
+static GLenum FromTextureFormatToInternalFormat(TextureFormat format)
+{
+    switch(format)
+    {
+        case TextureFormat::RGBA8:
+            return GL_RGBA8;
+        case TextureFormat::RGBA16F:
+            return GL_RGBA16F;
+        case TextureFormat::Depth24Stencil8:
+            return GL_DEPTH24_STENCIL8;
+        default:
+            return GL_NONE;
+    }
+}
+
+static GLenum FromTextureFormatToFormat(TextureFormat format)
+{
+    switch(format)
+    {
+        case TextureFormat::RGBA8:
+        case TextureFormat::RGBA16F:
+            return GL_RGBA;
+        case TextureFormat::Depth24Stencil8:
+            return GL_DEPTH_STENCIL;
+        default:
+            return GL_NONE;
+    }
+}
+
+static GLenum FromTextureFormatToType(TextureFormat format)
+{
+    switch(format)
+    {
+        case TextureFormat::RGBA8:
+            return GL_UNSIGNED_BYTE;
+        case TextureFormat::RGBA16F:
+            return GL_HALF_FLOAT;
+        case TextureFormat::Depth24Stencil8:
+            return GL_UNSIGNED_INT_24_8;
+        default:
+            return GL_NONE;
+    }
+}
+
+static const char* FromTextureFormatToString(TextureFormat format)
+{
+    switch(format)
+    {
+        case TextureFormat::RGBA8:
+            return "RGBA8";
+        case TextureFormat::RGBA16F:
+            return "RGBA16F";
+        case TextureFormat::Depth24Stencil8:
+            return "Depth24Stencil8";
+        default:
+            return "Unknown";
+    }
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+enum class TextureFormat
+{
+    RGBA8,
+    RGBA16F,
+    Depth24Stencil8
+};
+
+struct TextureDesc
+{
+    int width = 0;
+    int height = 0;
+    TextureFormat format = TextureFormat::RGBA8;
+};
+
+bool operator==(const TextureDesc& lhs, const TextureDesc& rhs);
+
+// Index of a resource or pass inside the graph it was added to
+using ResourceHandle = uint32_t;
+using PassHandle = uint32_t;
+
+static const uint32_t INVALID_HANDLE = UINT32_MAX;
+
+class RenderGraph;
+
+// Handed to a pass while it executes. The pass's output framebuffer is already bound and the viewport set
+class RenderPassContext
+{
+public:
+    RenderPassContext(const RenderGraph& graph);
+
+    GLuint GetTexture(ResourceHandle resource) const;
+
+private:
+    const RenderGraph& graph;
+};
+
+struct PassTiming
+{
+    double cpuMilliseconds = 0.0;
+    double gpuMilliseconds = 0.0;
+};
+
+// Frame description made of passes that declare which textures they read and write.
+// Compile() culls passes whose results are never consumed, orders the rest and packs transient textures with
+// disjoint lifetimes onto shared physical textures. Compile() makes no GL calls; Execute() creates the GL objects
+class RenderGraph
+{
+public:
+    // clears passes and resources but keeps the GL textures so they can be reused by the next build.
+    // Execute() frees the kept textures that build does not claim, e.g. all of them after a resize
+    void Reset();
+    void Dispose();
+
+    // transient textures are owned by the graph and may share memory with other transient textures
+    ResourceHandle CreateTexture(const std::string& name, const TextureDesc& desc);
+    // imported resources live outside the graph and are never culled or aliased
+    ResourceHandle ImportTexture(const std::string& name, GLuint texture, const TextureDesc& desc);
+    // a pass that writes an imported framebuffer may not write anything else, Compile() fails otherwise
+    ResourceHandle ImportFramebuffer(const std::string& name, GLuint framebuffer, int width, int height);
+
+    PassHandle AddPass(const std::string& name, std::function<void(RenderPassContext&)> execute);
+    void Read(PassHandle pass, ResourceHandle resource);
+    void Write(PassHandle pass, ResourceHandle resource);
+    // keeps the writers of a transient texture alive even if no pass reads it, and keeps its memory out of aliasing
+    void MarkOutput(ResourceHandle resource);
+
+    bool Compile();
+    void Execute();
+
+    bool IsPassCulled(PassHandle pass) const;
+    const std::vector<PassHandle>& GetExecutionOrder() const;
+    // physical texture slot the transient resource was assigned to, INVALID_HANDLE for imported or unused ones
+    uint32_t GetPhysicalIndex(ResourceHandle resource) const;
+    uint32_t GetPhysicalCount() const;
+    // GL texture backing a resource after Execute(), e.g. to read an output. Stays valid until the next Compile() or Reset()
+    GLuint GetTexture(ResourceHandle resource) const;
+    // timings of the most recent frame whose GPU results have arrived, keyed by pass name
+    const std::map<std::string, PassTiming>& GetTimings() const;
+
+    void Dump(std::ostream& stream) const;
+
+private:
+    struct Resource
+    {
+        std::string name;
+        TextureDesc desc;
+        bool imported = false;
+        bool output = false;
+        GLuint texture = 0;
+        GLuint framebuffer = 0;
+        bool isFramebuffer = false;
+
+        // filled in by Compile()
+        uint32_t firstUse = INVALID_HANDLE;
+        uint32_t lastUse = INVALID_HANDLE;
+        uint32_t physical = INVALID_HANDLE;
+    };
+
+    struct Pass
+    {
+        std::string name;
+        std::function<void(RenderPassContext&)> execute;
+        std::vector<ResourceHandle> reads;
+        std::vector<ResourceHandle> writes;
+        bool culled = false;
+    };
+
+    struct PhysicalTexture
+    {
+        TextureDesc desc;
+        GLuint texture = 0;
+    };
+
+    struct PassTimer
+    {
+        GLuint queries[2] = {0, 0};
+        bool pending[2] = {false, false};
+    };
+
+    void CullPasses();
+    bool SortPasses();
+    void AssignPhysicalTextures();
+    bool ValidatePasses() const;
+    // returns false, and the pass is skipped, when its attachments do not form a complete framebuffer
+    bool BindOutputs(const Pass& pass);
+
+    std::vector<Resource> resources;
+    std::vector<Pass> passes;
+    std::vector<PassHandle> executionOrder;
+    std::vector<PhysicalTexture> physicalTextures;
+    bool compiled = false;
+
+    // GL state kept across Reset()
+    std::vector<PhysicalTexture> texturePool;
+    GLuint framebuffer = 0;
+    uint32_t attachedColorCount = 0;
+    bool attachedDepth = false;
+    std::map<std::string, PassTimer> timers;
+    std::map<std::string, PassTiming> timings;
+    uint32_t frameIndex = 0;
+};
@@ -0,0 +1,459 @@
+#include "scene.h"
+
+#include "thread_pool.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iostream>
+
+static void InitChunk(Chunk& chunk, ComponentMask mask);
+static void MoveRow(Chunk& dst, size_t dstRow, Chunk& src, size_t srcRow);
+
+Entity Scene::CreateEntity(ComponentMask mask)
+{
+    uint32_t archetypeIndex = FindOrCreateArchetype(mask);
+    Archetype& archetype = archetypes[archetypeIndex];
+
+    // fill the last occupied chunk first, then the empty spare behind it, and only then allocate a new chunk
+    size_t chunkIndex = archetype.chunks.size();
+    if(!archetype.chunks.empty())
+    {
+        chunkIndex = archetype.chunks.size() - 1;
+        if(archetype.chunks[chunkIndex].count == 0 && chunkIndex > 0 && archetype.chunks[chunkIndex - 1].count < CHUNK_CAPACITY)
+        {
+            chunkIndex--;
+        }
+        else if(archetype.chunks[chunkIndex].count == CHUNK_CAPACITY)
+        {
+            chunkIndex = archetype.chunks.size();
+        }
+    }
+
+    if(chunkIndex == archetype.chunks.size())
+    {
+        archetype.chunks.emplace_back();
+        InitChunk(archetype.chunks.back(), mask);
+    }
+
+    uint32_t index;
+    if(!freeIndices.empty())
+    {
+        index = freeIndices.back();
+        freeIndices.pop_back();
+    }
+    else
+    {
+        index = static_cast<uint32_t>(records.size());
+        records.emplace_back();
+    }
+
+    Chunk& chunk = archetype.chunks[chunkIndex];
+    size_t row = chunk.count++;
+
+    EntityRecord& record = records[index];
+    record.archetype = archetypeIndex;
+    record.chunk = static_cast<uint32_t>(chunkIndex);
+    record.row = static_cast<uint32_t>(row);
+    record.alive = true;
+
+    Entity entity{index, record.generation};
+
+    // rows are recycled, so reset whatever the previous occupant left behind
+    chunk.entities[row] = entity;
+    if(mask & ComponentTransform)
+    {
+        chunk.transforms[row] = TransformComponent{};
+    }
+    if(mask & ComponentRenderable)
+    {
+        chunk.renderables[row] = RenderableComponent{};
+    }
+    if(mask & ComponentAnimation)
+    {
+        chunk.animations[row] = AnimationComponent{};
+    }
+    if(mask & ComponentBounds)
+    {
+        chunk.bounds[row] = BoundsComponent{};
+    }
+
+    entityCount++;
+    return entity;
+}
+
+void Scene::DestroyEntity(Entity entity)
+{
+    if(!IsAlive(entity))
+    {
+        return;
+    }
+
+    EntityRecord& record = records[entity.index];
+    Archetype& archetype = archetypes[record.archetype];
+    // the back chunk may be an empty spare, the archetype's last entity then lives in the one before it
+    size_t lastChunkIndex = archetype.chunks.size() - (archetype.chunks.back().count == 0 ? 2 : 1);
+    Chunk& lastChunk = archetype.chunks[lastChunkIndex];
+    size_t lastRow = lastChunk.count - 1;
+
+    // keep chunks dense by filling the hole with the archetype's last entity
+    Chunk& chunk = archetype.chunks[record.chunk];
+    if(&chunk != &lastChunk || record.row != lastRow)
+    {
+        MoveRow(chunk, record.row, lastChunk, lastRow);
+
+        EntityRecord& movedRecord = records[chunk.entities[record.row].index];
+        movedRecord.chunk = record.chunk;
+        movedRecord.row = record.row;
+    }
+
+    // an emptied chunk stays around as a spare so churn across a chunk boundary does not reallocate its columns.
+    // Only one spare is kept, an older one behind it is released
+    lastChunk.count--;
+    if(lastChunk.count == 0 && lastChunkIndex + 1 < archetype.chunks.size())
+    {
+        archetype.chunks.pop_back();
+    }
+
+    record.alive = false;
+    record.generation++;
+    freeIndices.push_back(entity.index);
+    entityCount--;
+}
+
+void Scene::Clear()
+{
+    archetypes.clear();
+    records.clear();
+    freeIndices.clear();
+    entityCount = 0;
+}
+
+bool Scene::IsAlive(Entity entity) const
+{
+    return entity.index < records.size() && records[entity.index].alive && records[entity.index].generation == entity.generation;
+}
+
+size_t Scene::GetEntityCount() const
+{
+    return entityCount;
+}
+
+TransformComponent* Scene::GetTransform(Entity entity)
+{
+    uint32_t row;
+    Chunk* chunk = GetChunk(entity, &row);
+    return chunk != nullptr && !chunk->transforms.empty() ? &chunk->transforms[row] : nullptr;
+}
+
+RenderableComponent* Scene::GetRenderable(Entity entity)
+{
+    uint32_t row;
+    Chunk* chunk = GetChunk(entity, &row);
+    return chunk != nullptr && !chunk->renderables.empty() ? &chunk->renderables[row] : nullptr;
+}
+
+AnimationComponent* Scene::GetAnimation(Entity entity)
+{
+    uint32_t row;
+    Chunk* chunk = GetChunk(entity, &row);
+    return chunk != nullptr && !chunk->animations.empty() ? &chunk->animations[row] : nullptr;
+}
+
+BoundsComponent* Scene::GetBounds(Entity entity)
+{
+    uint32_t row;
+    Chunk* chunk = GetChunk(entity, &row);
+    return chunk != nullptr && !chunk->bounds.empty() ? &chunk->bounds[row] : nullptr;
+}
+
+void Scene::ForEachChunk(ComponentMask required, const std::function<void(Chunk&)>& func)
+{
+    for(Archetype& archetype : archetypes)
+    {
+        if((archetype.mask & required) != required)
+        {
+            continue;
+        }
+
+        for(Chunk& chunk : archetype.chunks)
+        {
+            if(chunk.count != 0)
+            {
+                func(chunk);
+            }
+        }
+    }
+}
+
+void Scene::ParallelForEachChunk(ComponentMask required, ThreadPool& threadPool, const std::function<void(Chunk&)>& func)
+{
+    std::vector<Chunk*> chunks;
+    ForEachChunk(required, [&chunks](Chunk& chunk) { chunks.push_back(&chunk); });
+
+    threadPool.ParallelFor(chunks.size(), [&chunks, &func](size_t i) { func(*chunks[i]); });
+}
+
+uint32_t Scene::FindOrCreateArchetype(ComponentMask mask)
+{
+    for(size_t i = 0; i < archetypes.size(); i++)
+    {
+        if(archetypes[i].mask == mask)
+        {
+            return static_cast<uint32_t>(i);
+        }
+    }
+
+    archetypes.emplace_back();
+    archetypes.back().mask = mask;
+    return static_cast<uint32_t>(archetypes.size() - 1);
+}
+
+Chunk* Scene::GetChunk(Entity entity, uint32_t* row)
+{
+    if(!IsAlive(entity))
+    {
+        return nullptr;
+    }
+
+    const EntityRecord& record = records[entity.index];
+    *row = record.row;
+    return &archetypes[record.archetype].chunks[record.chunk];
+}
+
+void UpdateAnimationSystem(Scene& scene, ThreadPool& threadPool, float time)
+{
+    scene.ParallelForEachChunk(ComponentTransform | ComponentAnimation, threadPool, [time](Chunk& chunk)
+    {
+        for(size_t i = 0; i < chunk.count; i++)
+        {
+            const AnimationComponent& animation = chunk.animations[i];
+            chunk.transforms[i].rotationAngle = animation.phase + animation.angularSpeed * time;
+        }
+    });
+}
+
+void UpdateTransformSystem(Scene& scene, ThreadPool& threadPool)
+{
+    scene.ParallelForEachChunk(ComponentTransform, threadPool, [](Chunk& chunk)
+    {
+        for(size_t i = 0; i < chunk.count; i++)
+        {
+            TransformComponent& transform = chunk.transforms[i];
+
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), transform.position);
+            model = glm::rotate(model, glm::radians(transform.rotationAngle), transform.rotationAxis);
+            transform.model = glm::scale(model, transform.scale);
+        }
+    });
+}
+
+void UpdateCullSystem(Scene& scene, ThreadPool& threadPool, const glm::mat4& viewProj)
+{
+    // extract the frustum planes from the combined matrix (Gribb/Hartmann), pointing inwards
+    glm::vec4 row0{viewProj[0][0], viewProj[1][0], viewProj[2][0], viewProj[3][0]};
+    glm::vec4 row1{viewProj[0][1], viewProj[1][1], viewProj[2][1], viewProj[3][1]};
+    glm::vec4 row2{viewProj[0][2], viewProj[1][2], viewProj[2][2], viewProj[3][2]};
+    glm::vec4 row3{viewProj[0][3], viewProj[1][3], viewProj[2][3], viewProj[3][3]};
+
+    std::array<glm::vec4, 6> planes = {
+        row3 + row0, row3 - row0,
+        row3 + row1, row3 - row1,
+        row3 + row2, row3 - row2
+    };
+
+    for(glm::vec4& plane : planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+
+    scene.ParallelForEachChunk(ComponentTransform | ComponentRenderable | ComponentBounds, threadPool, [&planes](Chunk& chunk)
+    {
+        for(size_t i = 0; i < chunk.count; i++)
+        {
+            const glm::mat4& model = chunk.transforms[i].model;
+            const BoundsComponent& bounds = chunk.bounds[i];
+
+            glm::vec3 center = glm::vec3(model * glm::vec4(bounds.center, 1.0f));
+            float maxScale = std::max({glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))});
+            float radius = bounds.radius * maxScale;
+
+            bool visible = true;
+            for(const glm::vec4& plane : planes)
+            {
+                if(glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+                {
+                    visible = false;
+                    break;
+                }
+            }
+
+            chunk.renderables[i].visible = visible;
+        }
+    });
+}
+
+bool SceneRenderer::Create()
+{
+    glGenBuffers(1, &instanceBuffer);
+    return instanceBuffer != 0;
+}
+
+void SceneRenderer::Dispose()
+{
+    if(instanceBuffer != 0)
+    {
+        glDeleteBuffers(1, &instanceBuffer);
+        instanceBuffer = 0;
+    }
+
+    batches.clear();
+    uploadData.clear();
+}
+
+void SceneRenderer::Draw(Scene& scene, uint32_t materialCount)
+{
+    for(Batch& batch : batches)
+    {
+        batch.instances.clear();
+    }
+
+    scene.ForEachChunk(ComponentTransform | ComponentRenderable, [&](Chunk& chunk)
+    {
+        Batch* batch = nullptr;
+
+        for(size_t i = 0; i < chunk.count; i++)
+        {
+            const RenderableComponent& renderable = chunk.renderables[i];
+            if(!renderable.visible)
+            {
+                continue;
+            }
+
+            // an out of range index into the shader's material table is undefined behaviour
+            if(renderable.materialId >= materialCount)
+            {
+                if(!reportedInvalidMaterial)
+                {
+                    std::cout << "ERROR::SCENE::MATERIAL_ID_OUT_OF_RANGE " << renderable.materialId << std::endl;
+                    reportedInvalidMaterial = true;
+                }
+                continue;
+            }
+
+            if(batch == nullptr || batch->vao != renderable.vao || batch->vertexCount != renderable.vertexCount)
+            {
+                auto found = std::find_if(batches.begin(), batches.end(), [&renderable](const Batch& candidate)
+                {
+                    return candidate.vao == renderable.vao && candidate.vertexCount == renderable.vertexCount;
+                });
+
+                if(found == batches.end())
+                {
+                    batches.emplace_back();
+                    batches.back().vao = renderable.vao;
+                    batches.back().vertexCount = renderable.vertexCount;
+                    found = batches.end() - 1;
+                }
+
+                batch = &*found;
+            }
+
+            batch->instances.push_back(SceneInstance{chunk.transforms[i].model, static_cast<int32_t>(renderable.materialId)});
+        }
+    });
+
+    // all batches share one orphaned buffer, each draw points the instance attributes at its own range
+    uploadData.clear();
+    for(const Batch& batch : batches)
+    {
+        uploadData.insert(uploadData.end(), batch.instances.begin(), batch.instances.end());
+    }
+
+    if(uploadData.empty())
+    {
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, uploadData.size() * sizeof(SceneInstance), uploadData.data(), GL_STREAM_DRAW);
+
+    size_t firstInstance = 0;
+    for(const Batch& batch : batches)
+    {
+        if(batch.instances.empty())
+        {
+            continue;
+        }
+
+        glBindVertexArray(batch.vao);
+
+        size_t offset = firstInstance * sizeof(SceneInstance);
+        for(GLuint column = 0; column < 4; column++)
+        {
+            GLuint location = 2 + column;
+            glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(SceneInstance),
+                                  reinterpret_cast<void*>(offset + offsetof(SceneInstance, model) + column * sizeof(glm::vec4)));
+            glVertexAttribDivisor(location, 1);
+            glEnableVertexAttribArray(location);
+        }
+
+        glVertexAttribIPointer(6, 1, GL_INT, sizeof(SceneInstance), reinterpret_cast<void*>(offset + offsetof(SceneInstance, materialId)));
+        glVertexAttribDivisor(6, 1);
+        glEnableVertexAttribArray(6);
+
+        glDrawArraysInstanced(GL_TRIANGLES, 0, batch.vertexCount, static_cast<GLsizei>(batch.instances.size()));
+
+        firstInstance += batch.instances.size();
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+static void InitChunk(Chunk& chunk, ComponentMask mask)
+{
+    chunk.count = 0;
+    chunk.entities.resize(CHUNK_CAPACITY);
+
+    if(mask & ComponentTransform)
+    {
+        chunk.transforms.resize(CHUNK_CAPACITY);
+    }
+    if(mask & ComponentRenderable)
+    {
+        chunk.renderables.resize(CHUNK_CAPACITY);
+    }
+    if(mask & ComponentAnimation)
+    {
+        chunk.animations.resize(CHUNK_CAPACITY);
+    }
+    if(mask & ComponentBounds)
+    {
+        chunk.bounds.resize(CHUNK_CAPACITY);
+    }
+}
+
+static void MoveRow(Chunk& dst, size_t dstRow, Chunk& src, size_t srcRow)
+{
+    dst.entities[dstRow] = src.entities[srcRow];
+
+    if(!dst.transforms.empty())
+    {
+        dst.transforms[dstRow] = src.transforms[srcRow];
+    }
+    if(!dst.renderables.empty())
+    {
+        dst.renderables[dstRow] = src.renderables[srcRow];
+    }
+    if(!dst.animations.empty())
+    {
+        dst.animations[dstRow] = src.animations[srcRow];
+    }
+    if(!dst.bounds.empty())
+    {
+        dst.bounds[dstRow] = src.bounds[srcRow];
+    }
+}
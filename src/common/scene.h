@@ -0,0 +1,162 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+class ThreadPool;
+
+// Component bits. An entity's mask decides which archetype (and therefore which chunk columns) it lives in
+using ComponentMask = uint32_t;
+
+enum ComponentBits : ComponentMask
+{
+    ComponentTransform  = 1 << 0,
+    ComponentRenderable = 1 << 1,
+    ComponentAnimation  = 1 << 2,
+    ComponentBounds     = 1 << 3
+};
+
+// Number of entities stored in a single chunk
+static const size_t CHUNK_CAPACITY = 1024;
+
+struct Entity
+{
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+};
+
+struct TransformComponent
+{
+    glm::vec3 position{0.0f};
+    glm::vec3 rotationAxis{0.0f, 1.0f, 0.0f};
+    float rotationAngle = 0.0f; // degrees
+    glm::vec3 scale{1.0f};
+    glm::mat4 model{1.0f};
+};
+
+struct RenderableComponent
+{
+    GLuint vao = 0;
+    GLsizei vertexCount = 0;
+    // index into the shader's material table, which maps to texture array layers. Passed per instance
+    uint32_t materialId = 0;
+    bool visible = true;
+};
+
+// rotationAngle = phase + angularSpeed * time
+struct AnimationComponent
+{
+    float angularSpeed = 0.0f; // degrees per second
+    float phase = 0.0f;        // degrees
+};
+
+// Bounding sphere in object space
+struct BoundsComponent
+{
+    glm::vec3 center{0.0f};
+    float radius = 0.0f;
+};
+
+// A fixed-capacity block of entities sharing one archetype. Every present component is a contiguous column indexed by row
+struct Chunk
+{
+    size_t count = 0;
+    std::vector<Entity> entities;
+    std::vector<TransformComponent> transforms;
+    std::vector<RenderableComponent> renderables;
+    std::vector<AnimationComponent> animations;
+    std::vector<BoundsComponent> bounds;
+};
+
+struct Archetype
+{
+    ComponentMask mask = 0;
+    // every chunk but the last occupied one is full. The back chunk may be an empty spare kept for reuse
+    std::vector<Chunk> chunks;
+};
+
+// Data-oriented entity storage. Entities are created with a fixed component mask and packed densely into archetype chunks
+class Scene
+{
+public:
+    Entity CreateEntity(ComponentMask mask);
+    void DestroyEntity(Entity entity);
+    void Clear();
+
+    bool IsAlive(Entity entity) const;
+    size_t GetEntityCount() const;
+
+    // returned pointers are only valid until the next CreateEntity or DestroyEntity call
+    TransformComponent* GetTransform(Entity entity);
+    RenderableComponent* GetRenderable(Entity entity);
+    AnimationComponent* GetAnimation(Entity entity);
+    BoundsComponent* GetBounds(Entity entity);
+
+    // calls func for every non-empty chunk whose archetype contains all the required components
+    void ForEachChunk(ComponentMask required, const std::function<void(Chunk&)>& func);
+
+    // same as ForEachChunk, but chunks are spread over the pool's workers. func must only touch the chunk it is given
+    void ParallelForEachChunk(ComponentMask required, ThreadPool& threadPool, const std::function<void(Chunk&)>& func);
+
+private:
+    struct EntityRecord
+    {
+        uint32_t generation = 0;
+        uint32_t archetype = 0;
+        uint32_t chunk = 0;
+        uint32_t row = 0;
+        bool alive = false;
+    };
+
+    uint32_t FindOrCreateArchetype(ComponentMask mask);
+    Chunk* GetChunk(Entity entity, uint32_t* row);
+
+    std::vector<Archetype> archetypes;
+    std::vector<EntityRecord> records;
+    std::vector<uint32_t> freeIndices;
+    size_t entityCount = 0;
+};
+
+// advances the rotation of every animated transform to the given time
+void UpdateAnimationSystem(Scene& scene, ThreadPool& threadPool, float time);
+
+// rebuilds the model matrix of every transform
+void UpdateTransformSystem(Scene& scene, ThreadPool& threadPool);
+
+// marks renderables visible when their world-space bounding sphere intersects the view frustum
+void UpdateCullSystem(Scene& scene, ThreadPool& threadPool, const glm::mat4& viewProj);
+
+// Per-instance vertex attributes read by triangle.vert: model matrix at locations 2-5, material ID at location 6
+struct SceneInstance
+{
+    glm::mat4 model;
+    int32_t materialId;
+};
+
+// Draws every visible renderable with one instanced draw per mesh (VAO and vertex count), whatever its material
+class SceneRenderer
+{
+public:
+    bool Create();
+    void Dispose();
+
+    // the pipeline must already be active. Renderables whose materialId is not below materialCount are skipped
+    void Draw(Scene& scene, uint32_t materialCount);
+
+private:
+    struct Batch
+    {
+        GLuint vao = 0;
+        GLsizei vertexCount = 0;
+        std::vector<SceneInstance> instances;
+    };
+
+    GLuint instanceBuffer = 0;
+    std::vector<Batch> batches;
+    std::vector<SceneInstance> uploadData;
+    bool reportedInvalidMaterial = false;
+};
@@ -0,0 +1,155 @@
+#include "texture_array.h"
+
+#include <algorithm>
+#include <cstring>
+
+static GLuint CreateArrayTexture(int width, int height, uint32_t layerCount);
+static void CopyLayers(GLuint source, GLuint destination, int width, int height, uint32_t layerCount);
+
+TextureHandle TextureArrayManager::AddTexture(int width, int height, const unsigned char* pixels)
+{
+    if(maxLayers == 0)
+    {
+        // the GL 3.3 minimum is 256
+        GLint limit = 0;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &limit);
+        maxLayers = limit > 0 ? static_cast<uint32_t>(limit) : 256;
+    }
+
+    uint32_t arrayIndex = 0;
+    while(arrayIndex < arrays.size() &&
+          (arrays[arrayIndex].width != width || arrays[arrayIndex].height != height || arrays[arrayIndex].layers.size() >= maxLayers))
+    {
+        arrayIndex++;
+    }
+
+    if(arrayIndex == arrays.size())
+    {
+        arrays.emplace_back();
+        arrays.back().width = width;
+        arrays.back().height = height;
+    }
+
+    TextureArray& array = arrays[arrayIndex];
+
+    size_t size = static_cast<size_t>(width) * static_cast<size_t>(height) * 4;
+    array.layers.emplace_back(size);
+    std::memcpy(array.layers.back().data(), pixels, size);
+
+    return TextureHandle{arrayIndex, static_cast<uint32_t>(array.layers.size() - 1)};
+}
+
+void TextureArrayManager::Upload()
+{
+    for(TextureArray& array : arrays)
+    {
+        uint32_t layerCount = static_cast<uint32_t>(array.layers.size());
+        if(array.uploadedLayers == layerCount)
+        {
+            continue;
+        }
+
+        // a GL array cannot be resized in place, so grow geometrically and copy the uploaded layers over when it is full
+        if(layerCount > array.allocatedLayers)
+        {
+            uint32_t allocatedLayers = array.allocatedLayers == 0 ? layerCount : array.allocatedLayers;
+            while(allocatedLayers < layerCount)
+            {
+                allocatedLayers *= 2;
+            }
+            // AddTexture() never puts more than maxLayers into one array
+            allocatedLayers = std::min(allocatedLayers, maxLayers);
+
+            GLuint texture = CreateArrayTexture(array.width, array.height, allocatedLayers);
+            if(array.texture != 0)
+            {
+                CopyLayers(array.texture, texture, array.width, array.height, array.uploadedLayers);
+                glDeleteTextures(1, &array.texture);
+            }
+
+            array.texture = texture;
+            array.allocatedLayers = allocatedLayers;
+        }
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+
+        for(uint32_t layer = array.uploadedLayers; layer < layerCount; layer++)
+        {
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<GLint>(layer), array.width, array.height, 1,
+                            GL_RGBA, GL_UNSIGNED_BYTE, array.layers[layer].data());
+
+            // the GPU copy is the only one from now on
+            std::vector<unsigned char>().swap(array.layers[layer]);
+        }
+        array.uploadedLayers = layerCount;
+
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void TextureArrayManager::Dispose()
+{
+    for(TextureArray& array : arrays)
+    {
+        if(array.texture != 0)
+        {
+            glDeleteTextures(1, &array.texture);
+        }
+    }
+
+    arrays.clear();
+}
+
+uint32_t TextureArrayManager::GetArrayCount() const
+{
+    return static_cast<uint32_t>(arrays.size());
+}
+
+GLuint TextureArrayManager::GetTexture(uint32_t array) const
+{
+    return arrays[array].texture;
+}
+
+void TextureArrayManager::Bind(GLuint firstUnit) const
+{
+    for(size_t i = 0; i < arrays.size(); i++)
+    {
+        glActiveTexture(GL_TEXTURE0 + firstUnit + static_cast<GLuint>(i));
+        glBindTexture(GL_TEXTURE_2D_ARRAY, arrays[i].texture);
+    }
+}
+
+static GLuint CreateArrayTexture(int width, int height, uint32_t layerCount)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, static_cast<GLsizei>(layerCount), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    return texture;
+}
+
+static void CopyLayers(GLuint source, GLuint destination, int width, int height, uint32_t layerCount)
+{
+    // GL 3.3 has no glCopyImageSubData, so each layer is attached to a read framebuffer and copied from there.
+    // Only level 0 is copied, Upload() rebuilds the mipmaps afterwards
+    GLuint framebuffer;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, destination);
+
+    for(uint32_t layer = 0; layer < layerCount; layer++)
+    {
+        glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, source, 0, static_cast<GLint>(layer));
+        glCopyTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<GLint>(layer), 0, 0, width, height);
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <vector>
+
+// Location of a texture inside the manager: which GL_TEXTURE_2D_ARRAY and which layer of it
+struct TextureHandle
+{
+    uint32_t array = UINT32_MAX;
+    uint32_t layer = UINT32_MAX;
+};
+
+// Packs RGBA8 textures of the same size into layers of shared GL_TEXTURE_2D_ARRAY objects,
+// so a whole frame can sample every texture through one bind per array instead of one bind per material.
+// A size gets a new array once its current one reaches GL_MAX_ARRAY_TEXTURE_LAYERS
+class TextureArrayManager
+{
+public:
+    // copies width * height RGBA8 texels. Nothing reaches the GPU until Upload(), but a GL context must be current
+    TextureHandle AddTexture(int width, int height, const unsigned char* pixels);
+    // creates or grows the GL arrays and uploads pending layers, then rebuilds their mipmaps.
+    // The CPU copies of the uploaded layers are freed, growing an array copies its layers on the GPU
+    void Upload();
+    void Dispose();
+
+    uint32_t GetArrayCount() const;
+    GLuint GetTexture(uint32_t array) const;
+
+    // binds array i to texture unit firstUnit + i
+    void Bind(GLuint firstUnit) const;
+
+private:
+    struct TextureArray
+    {
+        int width = 0;
+        int height = 0;
+        // one entry per layer, emptied once the layer is on the GPU
+        std::vector<std::vector<unsigned char>> layers;
+        uint32_t allocatedLayers = 0;
+        uint32_t uploadedLayers = 0;
+        GLuint texture = 0;
+    };
+
+    std::vector<TextureArray> arrays;
+    uint32_t maxLayers = 0;
+};
@@ -0,0 +1,118 @@
+#include "thread_pool.h"
+
+bool ThreadPool::Create(uint32_t workerCount)
+{
+    if(workerCount == 0)
+    {
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+
+    stopping = false;
+    workers.reserve(workerCount);
+    for(uint32_t i = 0; i < workerCount; i++)
+    {
+        workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+
+    return true;
+}
+
+void ThreadPool::Dispose()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+
+    for(std::thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    workers.clear();
+}
+
+uint32_t ThreadPool::GetWorkerCount() const
+{
+    return static_cast<uint32_t>(workers.size());
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& job)
+{
+    if(count == 0)
+    {
+        return;
+    }
+
+    // not worth waking anyone up for a single item
+    if(workers.empty() || count == 1)
+    {
+        for(size_t i = 0; i < count; i++)
+        {
+            job(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentJob = &job;
+        jobCount = count;
+        nextIndex.store(0, std::memory_order_relaxed);
+        busyWorkers = workers.size();
+        batchId++;
+    }
+    wakeCondition.notify_all();
+
+    RunJobs(job, count);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCondition.wait(lock, [this] { return busyWorkers == 0; });
+    currentJob = nullptr;
+}
+
+void ThreadPool::WorkerLoop()
+{
+    uint64_t seenBatchId = 0;
+
+    while(true)
+    {
+        const std::function<void(size_t)>* job;
+        size_t count;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeCondition.wait(lock, [&] { return stopping || batchId != seenBatchId; });
+            if(stopping)
+            {
+                return;
+            }
+
+            seenBatchId = batchId;
+            job = currentJob;
+            count = jobCount;
+        }
+
+        RunJobs(*job, count);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busyWorkers--;
+            if(busyWorkers == 0)
+            {
+                doneCondition.notify_one();
+            }
+        }
+    }
+}
+
+void ThreadPool::RunJobs(const std::function<void(size_t)>& job, size_t count)
+{
+    size_t index;
+    while((index = nextIndex.fetch_add(1, std::memory_order_relaxed)) < count)
+    {
+        job(index);
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads that execute index ranges in parallel. The calling thread takes part in the work too
+class ThreadPool
+{
+public:
+    // spawns workerCount threads, or hardware_concurrency - 1 when workerCount is 0
+    bool Create(uint32_t workerCount = 0);
+    void Dispose();
+
+    uint32_t GetWorkerCount() const;
+
+    // calls job(i) for every i in [0, count) and returns once all of them have finished. Not re-entrant
+    void ParallelFor(size_t count, const std::function<void(size_t)>& job);
+
+private:
+    void WorkerLoop();
+    void RunJobs(const std::function<void(size_t)>& job, size_t count);
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable doneCondition;
+
+    const std::function<void(size_t)>* currentJob = nullptr;
+    size_t jobCount = 0;
+    std::atomic<size_t> nextIndex{0};
+    size_t busyWorkers = 0;
+    uint64_t batchId = 0;
+    bool stopping = false;
+};
@@ -9,19 +9,32 @@
 #include <iostream>
 #include <cmath>
 #include <sstream>
+#include <string>
 #include <vector>
 
 #include "camera.h"
+#include "frame_pacer.h"
+#include "particle_system.h"
 #include "pipeline.h"
+#include "render_graph.h"
+#include "scene.h"
+#include "texture_array.h"
+#include "thread_pool.h"
 
 static void FramebufferSizeCallback(GLFWwindow* window, int width, int height);
 static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
 static void MouseCallback(GLFWwindow* window, double xPos, double yPos);
 static void ScrollCallback(GLFWwindow* window, double xOffset, double yOffset);
 static void ProcessInput(GLFWwindow* window);
+static bool LoadTexture(const char* path, TextureHandle* handle);
+static bool SetMaterialTable(Pipeline& pipeline, const std::vector<TextureHandle>& baseTextures,
+                             const std::vector<TextureHandle>& overlayTextures);
 
 const int windowWidth   = 1600;
 const int windowHeight  = 1200;
+// must match MAX_MATERIALS and MAX_TEXTURE_ARRAYS in triangle.frag
+const uint32_t maxMaterials = 16;
+const uint32_t maxTextureArrays = 4;
 
 static std::vector<GLfloat> vertices = {
     -0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
@@ -92,13 +105,17 @@ static bool firstMouse = true;
 static float lastX = windowWidth / 2;
 static float lastY = windowHeight / 2;
 static Camera camera(glm::vec3{0.0f, 0.0f, 3.0f});
+static FramePacer framePacer;
 
 static GLuint VAO;
 static GLuint VBO;
 static GLuint EBO;
 static GLuint shaderProgram;
-static GLuint texture1;
-static GLuint texture2;
+static TextureArrayManager textureArrays;
+static uint32_t materialCount = 0;
+
+static bool dumpRenderGraph = false;
+static bool switchParticleBackend = false;
 
 int main()
 {
@@ -177,7 +194,7 @@ int main()
         return -1;
     }
 
-    PipelineCreateInfo pipelineCreateInfo{vertexShader, fragmentShader};
+    PipelineCreateInfo pipelineCreateInfo{vertexShader, fragmentShader, {}};
     Pipeline pipeline;
     if(!pipeline.Create(pipelineCreateInfo))
     {
@@ -187,105 +204,174 @@ int main()
     vertexShader.Dispose();
     fragmentShader.Dispose();
 
-    glGenTextures(1, &texture1);
-    glBindTexture(GL_TEXTURE_2D, texture1);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    TextureHandle containerTexture;
+    TextureHandle faceTexture;
+    if(!LoadTexture("./assets/textures/container.jpg", &containerTexture) ||
+       !LoadTexture("./assets/textures/awesomeface.png", &faceTexture))
+    {
+        return -1;
+    }
 
-    int width;
-    int height;
-    int nrChannels;
-    unsigned char* data = stbi_load("./assets/textures/container.jpg", &width, &height, &nrChannels, 0);
+    textureArrays.Upload();
 
-    if(data)
+    // both textures are 512x512 and end up as layers of the same array
+    if(!SetMaterialTable(pipeline, {containerTexture}, {faceTexture}))
     {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+        return -1;
     }
-    else
+
+    SceneRenderer sceneRenderer;
+    if(!sceneRenderer.Create())
     {
-        std::cout << "Failed to load texture" << std::endl;
         return -1;
     }
 
-    stbi_image_free(data);
+    ThreadPool threadPool;
+    threadPool.Create();
 
-    glGenTextures(1, &texture2);
-    glBindTexture(GL_TEXTURE_2D, texture2);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    RenderGraph renderGraph;
 
-    data = stbi_load("./assets/textures/awesomeface.png", &width, &height, &nrChannels, 0);
+    ParticleSystemCreateInfo particleInfo{};
+    particleInfo.backend = ParticleBackend::Gpu;
+    particleInfo.capacity = 200000;
+    particleInfo.threadPool = &threadPool;
+    particleInfo.emissionRate = 100000.0f;
+    particleInfo.emitterPosition = glm::vec3(0.0f, -1.0f, -4.0f);
 
-    if(data)
+    ParticleSystem particles;
+    if(!particles.Create(particleInfo))
     {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+        return -1;
     }
-    else
+
+    Scene scene;
+    for(size_t i = 0; i < cubePositions.size(); i++)
     {
-        std::cout << "Failed to load texture" << std::endl;
-        return -1;
+        Entity cube = scene.CreateEntity(ComponentTransform | ComponentRenderable | ComponentAnimation | ComponentBounds);
+
+        TransformComponent* transform = scene.GetTransform(cube);
+        transform->position = cubePositions[i];
+        transform->rotationAxis = glm::normalize(glm::vec3(1.0f, 0.3f, 0.0f));
+
+        RenderableComponent* renderable = scene.GetRenderable(cube);
+        renderable->vao = VAO;
+        renderable->vertexCount = static_cast<GLsizei>(vertices.size() / 5);
+        renderable->materialId = 0;
+
+        // every third cube spins, the rest keep a fixed tilt
+        AnimationComponent* animation = scene.GetAnimation(cube);
+        animation->angularSpeed = i % 3 == 0 ? 20.0f : 0.0f;
+        animation->phase = i % 3 == 0 ? 0.0f : 20.0f * i;
+
+        BoundsComponent* bounds = scene.GetBounds(cube);
+        bounds->radius = glm::length(glm::vec3(0.5f));
     }
 
-    stbi_image_free(data);
+    FramePacerCreateInfo framePacerInfo{};
+    framePacerInfo.swapInterval = 1;
+    framePacerInfo.maxFramesInFlight = 1;
+    framePacer.Create(framePacerInfo);
 
     while(!glfwWindowShouldClose(window))
     {
+        // block on the GPU and the frame cap first, then sample input as late as possible
+        framePacer.BeginFrame();
+        glfwPollEvents();
+
         float currentTime = static_cast<float>(glfwGetTime());
         deltaTime = currentTime - lastTime;
         lastTime = currentTime;
 
         ProcessInput(window);
 
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        glBindVertexArray(VAO);
-
-        pipeline.SetActive();
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture1);
-        pipeline.SetInt("texture1", 0);
-
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, texture2);
-        pipeline.SetInt("texture2", 1);
-
         int width;
         int height;
         glfwGetWindowSize(window, &width, &height);
 
         glm::mat4 view = camera.GetViewMatrix();
-        pipeline.SetMatrix4x4("view", view);
-
         glm::mat4 proj = glm::perspective(glm::radians(camera.Zoom), (float)width / (float)height, 0.1f, 100.0f);
-        pipeline.SetMatrix4x4("proj", proj);
 
-        for(size_t i = 0; i < cubePositions.size(); i++)
+        UpdateAnimationSystem(scene, threadPool, currentTime);
+        UpdateTransformSystem(scene, threadPool);
+        UpdateCullSystem(scene, threadPool, proj * view);
+
+        // simulated outside the graph so its pass timings only cover rendering
+        particles.Update(deltaTime);
+
+        int framebufferWidth;
+        int framebufferHeight;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+
+        renderGraph.Reset();
+        ResourceHandle backbuffer = renderGraph.ImportFramebuffer("backbuffer", 0, framebufferWidth, framebufferHeight);
+
+        PassHandle scenePass = renderGraph.AddPass("scene", [&](RenderPassContext&)
         {
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, cubePositions[i]);
+            glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-            float angle = i % 3 == 0 ? 20.0f * static_cast<float>(glfwGetTime()) : 20.0f * i;
-            model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.0f));
+            pipeline.SetActive();
+            textureArrays.Bind(0);
 
-            pipeline.SetMatrix4x4("model", model);
+            pipeline.SetMatrix4x4("view", view);
+            pipeline.SetMatrix4x4("proj", proj);
 
-            glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertices.size() / 3));
+            sceneRenderer.Draw(scene, materialCount);
+
+            glUseProgram(0);
+            glBindVertexArray(0);
+        });
+        renderGraph.Write(scenePass, backbuffer);
+
+        // drawn over the scene, so it is ordered after the scene pass by its write to the same backbuffer
+        PassHandle particlePass = renderGraph.AddPass("particles", [&](RenderPassContext&)
+        {
+            particles.Draw(view, proj, camera.Position, camera.Front);
+        });
+        renderGraph.Write(particlePass, backbuffer);
+
+        if(renderGraph.Compile())
+        {
+            renderGraph.Execute();
         }
 
-        glUseProgram(0);
-        glBindVertexArray(0);
+        if(switchParticleBackend)
+        {
+            particles.Dispose();
+            particleInfo.backend = particleInfo.backend == ParticleBackend::Gpu ? ParticleBackend::Cpu : ParticleBackend::Gpu;
+            if(!particles.Create(particleInfo))
+            {
+                return -1;
+            }
+
+            std::cout << "Particles: " << (particleInfo.backend == ParticleBackend::Gpu ? "GPU" : "CPU") << " backend" << std::endl;
+            switchParticleBackend = false;
+        }
+
+        if(dumpRenderGraph)
+        {
+            renderGraph.Dump(std::cout);
+
+            const ParticleStats& particleStats = particles.GetStats();
+            std::cout << "particle simulate: " << particleStats.simulateMilliseconds << " ms cpu";
+            if(particles.GetBackend() == ParticleBackend::Cpu)
+            {
+                std::cout << ", sort: " << particleStats.sortMilliseconds << " ms, alive: " << particleStats.aliveCount;
+            }
+            std::cout << std::endl;
+            dumpRenderGraph = false;
+        }
 
-        glfwPollEvents();
         glfwSwapBuffers(window);
+        framePacer.EndFrame();
     }
 
+    particles.Dispose();
+    framePacer.Dispose();
+    sceneRenderer.Dispose();
+    textureArrays.Dispose();
+    renderGraph.Dispose();
+    threadPool.Dispose();
     pipeline.Dispose();
 
     glDeleteBuffers(1, &EBO);
@@ -313,6 +399,23 @@ static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, i
         isWireframe = !isWireframe;
         glPolygonMode(GL_FRONT_AND_BACK, isWireframe ? GL_LINE : GL_FILL);
     }
+    else if(key == GLFW_KEY_G && action == GLFW_RELEASE)
+    {
+        dumpRenderGraph = true;
+    }
+    else if(key == GLFW_KEY_V && action == GLFW_RELEASE)
+    {
+        framePacer.SetSwapInterval(framePacer.GetSwapInterval() == 0 ? 1 : 0);
+        framePacer.ResetStatistics();
+    }
+    else if(key == GLFW_KEY_K && action == GLFW_RELEASE)
+    {
+        switchParticleBackend = true;
+    }
+    else if(key == GLFW_KEY_P && action == GLFW_RELEASE)
+    {
+        framePacer.Print(std::cout);
+    }
 }
 
 static void MouseCallback(GLFWwindow* window, double xPosIn, double yPosIn)
@@ -364,3 +467,58 @@ static void ProcessInput(GLFWwindow* window)
         camera.ProcessKeyboard(CameraMovement::RIGHT, deltaTime);
     }
 }
+
+static bool LoadTexture(const char* path, TextureHandle* handle)
+{
+    int width;
+    int height;
+    int nrChannels;
+    // always expand to RGBA so every texture of the same size can share one array
+    unsigned char* data = stbi_load(path, &width, &height, &nrChannels, 4);
+
+    if(!data)
+    {
+        std::cout << "Failed to load texture " << path << std::endl;
+        return false;
+    }
+
+    *handle = textureArrays.AddTexture(width, height, data);
+    stbi_image_free(data);
+
+    return true;
+}
+
+// the material table and sampler never change, so they are set once instead of every frame
+static bool SetMaterialTable(Pipeline& pipeline, const std::vector<TextureHandle>& baseTextures,
+                             const std::vector<TextureHandle>& overlayTextures)
+{
+    if(baseTextures.size() != overlayTextures.size() || baseTextures.size() > maxMaterials)
+    {
+        std::cout << "ERROR::MATERIALS::TOO_MANY_MATERIALS " << baseTextures.size() << std::endl;
+        return false;
+    }
+
+    std::vector<glm::ivec4> materials;
+    for(size_t i = 0; i < baseTextures.size(); i++)
+    {
+        // textures of different sizes live in different arrays, triangle.frag has a sampler for each of the first few
+        if(baseTextures[i].array >= maxTextureArrays || overlayTextures[i].array >= maxTextureArrays)
+        {
+            std::cout << "ERROR::MATERIALS::TOO_MANY_TEXTURE_ARRAYS material " << i << std::endl;
+            return false;
+        }
+
+        materials.push_back(glm::ivec4(baseTextures[i].array, baseTextures[i].layer, overlayTextures[i].array, overlayTextures[i].layer));
+    }
+
+    pipeline.SetActive();
+    for(uint32_t i = 0; i < maxTextureArrays; i++)
+    {
+        pipeline.SetInt("textures[" + std::to_string(i) + "]", static_cast<int>(i));
+    }
+    pipeline.SetIntVector4Array("materials", materials.data(), static_cast<GLsizei>(materials.size()));
+    glUseProgram(0);
+
+    materialCount = static_cast<uint32_t>(materials.size());
+    return true;
+}
@@ -0,0 +1,73 @@
+#include "frame_pacer.h"
+#include "test_common.h"
+
+// only the histogram is exercised, the pacer itself needs a GL context and a swap chain
+
+static void TestEmpty()
+{
+    FrameTimeHistogram histogram(1.0, 10);
+
+    CHECK(histogram.GetSampleCount() == 0);
+    CHECK(histogram.GetAverage() == 0.0);
+    CHECK(histogram.GetPercentile(50.0) == 0.0);
+    CHECK(histogram.GetBuckets().size() == 11);
+}
+
+static void TestPercentiles()
+{
+    FrameTimeHistogram histogram(1.0, 10);
+
+    for(int i = 0; i < 50; i++)
+    {
+        histogram.Add(0.5);
+    }
+    for(int i = 0; i < 45; i++)
+    {
+        histogram.Add(2.5);
+    }
+    for(int i = 0; i < 4; i++)
+    {
+        histogram.Add(7.5);
+    }
+    histogram.Add(25.0);
+
+    CHECK(histogram.GetSampleCount() == 100);
+    CHECK(IsNear(histogram.GetAverage(), 1.925, 1e-9));
+    CHECK(histogram.GetMax() == 25.0);
+
+    // percentiles report the upper edge of the bucket they fall into
+    CHECK(histogram.GetPercentile(0.0) == 1.0);
+    CHECK(histogram.GetPercentile(50.0) == 3.0);
+    CHECK(histogram.GetPercentile(95.0) == 8.0);
+}
+
+static void TestOverflowBucket()
+{
+    FrameTimeHistogram histogram(1.0, 10);
+    histogram.Add(3.5);
+    histogram.Add(40.0);
+    histogram.Add(12.0);
+
+    // everything past the range shares the last bucket, which has no upper edge and reports the max instead
+    CHECK(histogram.GetBuckets().back() == 2);
+    CHECK(histogram.GetPercentile(99.0) == 40.0);
+    CHECK(histogram.GetPercentile(100.0) == 40.0);
+
+    // negative durations (clock adjustments) land in the first bucket instead of indexing out of range
+    histogram.Add(-1.0);
+    CHECK(histogram.GetBuckets().front() == 1);
+
+    histogram.Clear();
+    CHECK(histogram.GetSampleCount() == 0);
+    CHECK(histogram.GetMax() == 0.0);
+    CHECK(histogram.GetBuckets().back() == 0);
+}
+
+int main()
+{
+    TestEmpty();
+    TestPercentiles();
+    TestOverflowBucket();
+
+    return TestResult();
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glfw/glfw3.h>
+
+// Opens an invisible 3.3 core window and makes its context current, for the tests and benchmarks that need GL.
+// Returns nullptr, with GLFW terminated again, when the machine has no display or no GL 3.3 driver
+inline GLFWwindow* CreateHiddenContext(const char* title)
+{
+    if(!glfwInit())
+    {
+        return nullptr;
+    }
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window = glfwCreateWindow(64, 64, title, nullptr, nullptr);
+    if(window == nullptr)
+    {
+        glfwTerminate();
+        return nullptr;
+    }
+
+    glfwMakeContextCurrent(window);
+    if(!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return nullptr;
+    }
+
+    return window;
+}
+
+inline void DestroyHiddenContext(GLFWwindow* window)
+{
+    glfwDestroyWindow(window);
+    glfwTerminate();
+}
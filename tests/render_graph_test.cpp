@@ -0,0 +1,210 @@
+#include <sstream>
+
+#include "render_graph.h"
+#include "test_common.h"
+
+// none of these tests execute the graph, so no GL context is needed
+
+static void NoOp(RenderPassContext&)
+{
+}
+
+static const TextureDesc colorDesc{800, 600, TextureFormat::RGBA16F};
+
+static void TestCulling()
+{
+    RenderGraph graph;
+    ResourceHandle backbuffer = graph.ImportFramebuffer("backbuffer", 0, 800, 600);
+    ResourceHandle gbuffer = graph.CreateTexture("gbuffer", colorDesc);
+    ResourceHandle debug = graph.CreateTexture("debug", colorDesc);
+    ResourceHandle kept = graph.CreateTexture("kept", colorDesc);
+
+    PassHandle geometry = graph.AddPass("geometry", NoOp);
+    graph.Write(geometry, gbuffer);
+
+    PassHandle debugPass = graph.AddPass("debug", NoOp);
+    graph.Read(debugPass, gbuffer);
+    graph.Write(debugPass, debug);
+
+    PassHandle outputPass = graph.AddPass("output", NoOp);
+    graph.Write(outputPass, kept);
+    graph.MarkOutput(kept);
+
+    PassHandle present = graph.AddPass("present", NoOp);
+    graph.Read(present, gbuffer);
+    graph.Write(present, backbuffer);
+
+    CHECK(graph.Compile());
+    CHECK(!graph.IsPassCulled(geometry));
+    CHECK(graph.IsPassCulled(debugPass));
+    CHECK(!graph.IsPassCulled(outputPass));
+    CHECK(!graph.IsPassCulled(present));
+    CHECK(graph.GetPhysicalIndex(debug) == INVALID_HANDLE);
+    CHECK(graph.GetPhysicalIndex(backbuffer) == INVALID_HANDLE);
+}
+
+static void TestOrdering()
+{
+    RenderGraph graph;
+    ResourceHandle backbuffer = graph.ImportFramebuffer("backbuffer", 0, 800, 600);
+    ResourceHandle a = graph.CreateTexture("a", colorDesc);
+    ResourceHandle b = graph.CreateTexture("b", colorDesc);
+
+    PassHandle first = graph.AddPass("first", NoOp);
+    graph.Write(first, a);
+
+    PassHandle second = graph.AddPass("second", NoOp);
+    graph.Read(second, a);
+    graph.Write(second, b);
+
+    PassHandle third = graph.AddPass("third", NoOp);
+    graph.Read(third, a);
+    graph.Read(third, b);
+    graph.Write(third, backbuffer);
+
+    // a second writer of the backbuffer lands after the first one
+    PassHandle overlay = graph.AddPass("overlay", NoOp);
+    graph.Write(overlay, backbuffer);
+
+    CHECK(graph.Compile());
+
+    const std::vector<PassHandle>& order = graph.GetExecutionOrder();
+    CHECK(order.size() == 4);
+    CHECK(order.size() == 4 && order[0] == first && order[1] == second && order[2] == third && order[3] == overlay);
+}
+
+static void TestFeedbackIsNotACycle()
+{
+    // the usual history/TAA pattern: read last frame's result, then overwrite it later in the same frame
+    RenderGraph graph;
+    ResourceHandle history = graph.ImportTexture("history", 1, colorDesc);
+    ResourceHandle x = graph.CreateTexture("x", colorDesc);
+
+    PassHandle resolve = graph.AddPass("resolve", NoOp);
+    graph.Read(resolve, history);
+    graph.Write(resolve, x);
+
+    PassHandle store = graph.AddPass("store", NoOp);
+    graph.Read(store, x);
+    graph.Write(store, history);
+
+    CHECK(graph.Compile());
+
+    const std::vector<PassHandle>& order = graph.GetExecutionOrder();
+    CHECK(order.size() == 2 && order[0] == resolve && order[1] == store);
+
+    // write after read: a later writer must wait for an earlier reader even without any other link between them
+    graph.Reset();
+    ResourceHandle backbuffer = graph.ImportFramebuffer("backbuffer", 0, 800, 600);
+    history = graph.ImportTexture("history", 1, colorDesc);
+
+    PassHandle reader = graph.AddPass("reader", NoOp);
+    graph.Read(reader, history);
+    graph.Write(reader, backbuffer);
+
+    PassHandle writer = graph.AddPass("writer", NoOp);
+    graph.Write(writer, history);
+
+    CHECK(graph.Compile());
+    CHECK(graph.GetExecutionOrder().size() == 2 && graph.GetExecutionOrder()[0] == reader);
+
+    // cycles cannot be declared any more, but Dump() must still describe a compiled graph
+    std::ostringstream dump;
+    graph.Dump(dump);
+    CHECK(dump.str().find("reader") != std::string::npos);
+    CHECK(dump.str().find("CYCLE") == std::string::npos);
+}
+
+static void TestAliasing()
+{
+    RenderGraph graph;
+    ResourceHandle backbuffer = graph.ImportFramebuffer("backbuffer", 0, 800, 600);
+    ResourceHandle gbuffer = graph.CreateTexture("gbuffer", colorDesc);
+    ResourceHandle lit = graph.CreateTexture("lit", colorDesc);
+    ResourceHandle bloom = graph.CreateTexture("bloom", colorDesc);
+    ResourceHandle depth = graph.CreateTexture("depth", TextureDesc{800, 600, TextureFormat::Depth24Stencil8});
+
+    PassHandle geometry = graph.AddPass("geometry", NoOp);
+    graph.Write(geometry, gbuffer);
+    graph.Write(geometry, depth);
+
+    PassHandle lighting = graph.AddPass("lighting", NoOp);
+    graph.Read(lighting, gbuffer);
+    graph.Write(lighting, lit);
+
+    PassHandle bloomPass = graph.AddPass("bloom", NoOp);
+    graph.Read(bloomPass, lit);
+    graph.Write(bloomPass, bloom);
+
+    PassHandle post = graph.AddPass("post", NoOp);
+    graph.Read(post, lit);
+    graph.Read(post, bloom);
+    graph.Read(post, depth);
+    graph.Write(post, backbuffer);
+
+    CHECK(graph.Compile());
+
+    // gbuffer dies after lighting, so bloom can take its memory; lit overlaps both
+    CHECK(graph.GetPhysicalIndex(gbuffer) == graph.GetPhysicalIndex(bloom));
+    CHECK(graph.GetPhysicalIndex(lit) != graph.GetPhysicalIndex(gbuffer));
+    // a different format never shares memory
+    CHECK(graph.GetPhysicalIndex(depth) != graph.GetPhysicalIndex(gbuffer));
+    CHECK(graph.GetPhysicalCount() == 3);
+}
+
+static void TestOutputsAreNotAliased()
+{
+    RenderGraph graph;
+    ResourceHandle backbuffer = graph.ImportFramebuffer("backbuffer", 0, 800, 600);
+    ResourceHandle out = graph.CreateTexture("out", colorDesc);
+    ResourceHandle tmp = graph.CreateTexture("tmp", colorDesc);
+    graph.MarkOutput(out);
+
+    PassHandle a = graph.AddPass("a", NoOp);
+    graph.Write(a, out);
+
+    PassHandle b = graph.AddPass("b", NoOp);
+    graph.Write(b, tmp);
+
+    PassHandle c = graph.AddPass("c", NoOp);
+    graph.Read(c, tmp);
+    graph.Write(c, backbuffer);
+
+    CHECK(graph.Compile());
+    CHECK(graph.GetPhysicalIndex(out) != INVALID_HANDLE);
+    CHECK(graph.GetPhysicalIndex(out) != graph.GetPhysicalIndex(tmp));
+}
+
+static void TestFramebufferWritesAreExclusive()
+{
+    RenderGraph graph;
+    ResourceHandle backbuffer = graph.ImportFramebuffer("backbuffer", 0, 800, 600);
+    ResourceHandle velocity = graph.CreateTexture("velocity", colorDesc);
+
+    // the framebuffer brings its own attachments, so the velocity write would be silently dropped
+    PassHandle mixed = graph.AddPass("mixed", NoOp);
+    graph.Write(mixed, backbuffer);
+    graph.Write(mixed, velocity);
+    graph.MarkOutput(velocity);
+
+    CHECK(!graph.Compile());
+    CHECK(graph.GetExecutionOrder().empty());
+
+    graph.Reset();
+    backbuffer = graph.ImportFramebuffer("backbuffer", 0, 800, 600);
+    PassHandle present = graph.AddPass("present", NoOp);
+    graph.Write(present, backbuffer);
+    CHECK(graph.Compile());
+}
+
+int main()
+{
+    TestCulling();
+    TestOrdering();
+    TestFeedbackIsNotACycle();
+    TestAliasing();
+    TestOutputsAreNotAliased();
+    TestFramebufferWritesAreExclusive();
+
+    return TestResult();
+}
@@ -0,0 +1,150 @@
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <vector>
+
+#include "scene.h"
+#include "test_common.h"
+#include "thread_pool.h"
+
+static const ComponentMask allComponents = ComponentTransform | ComponentRenderable | ComponentAnimation | ComponentBounds;
+
+static void TestCreateAndDefaults()
+{
+    Scene scene;
+    Entity entity = scene.CreateEntity(ComponentTransform | ComponentBounds);
+
+    CHECK(scene.IsAlive(entity));
+    CHECK(scene.GetEntityCount() == 1);
+    CHECK(scene.GetTransform(entity) != nullptr);
+    CHECK(scene.GetBounds(entity) != nullptr);
+    CHECK(scene.GetRenderable(entity) == nullptr);
+    CHECK(scene.GetAnimation(entity) == nullptr);
+    CHECK(scene.GetTransform(entity)->scale == glm::vec3(1.0f));
+}
+
+static void TestDestroyFillsHoleWithLastEntity()
+{
+    Scene scene;
+    std::vector<Entity> entities;
+
+    // more than one chunk so the swap-fill has to move a row across chunks
+    for(size_t i = 0; i < CHUNK_CAPACITY + 10; i++)
+    {
+        Entity entity = scene.CreateEntity(allComponents);
+        scene.GetTransform(entity)->position = glm::vec3(static_cast<float>(i), 0.0f, 0.0f);
+        entities.push_back(entity);
+    }
+
+    scene.DestroyEntity(entities[3]);
+    CHECK(!scene.IsAlive(entities[3]));
+    CHECK(scene.GetEntityCount() == CHUNK_CAPACITY + 9);
+
+    // every survivor still resolves to its own data
+    for(size_t i = 0; i < entities.size(); i++)
+    {
+        if(i == 3)
+        {
+            continue;
+        }
+
+        TransformComponent* transform = scene.GetTransform(entities[i]);
+        CHECK(transform != nullptr && transform->position.x == static_cast<float>(i));
+    }
+
+    // chunks stay dense: CHUNK_CAPACITY rows in the first chunk, the rest in the second
+    std::vector<size_t> counts;
+    scene.ForEachChunk(ComponentTransform, [&counts](Chunk& chunk) { counts.push_back(chunk.count); });
+    CHECK(counts.size() == 2 && counts[0] == CHUNK_CAPACITY && counts[1] == 9);
+
+    // emptying the last chunk keeps it as a spare that is skipped by iteration
+    TransformComponent* secondChunkStart = scene.GetTransform(entities[CHUNK_CAPACITY]);
+    for(size_t i = CHUNK_CAPACITY; i < entities.size(); i++)
+    {
+        scene.DestroyEntity(entities[i]);
+    }
+    counts.clear();
+    scene.ForEachChunk(ComponentTransform, [&counts](Chunk& chunk) { counts.push_back(chunk.count); });
+    CHECK(counts.size() == 1 && counts[0] == CHUNK_CAPACITY - 1);
+
+    // refilling the first chunk and crossing the boundary again reuses the spare's columns
+    Entity refill = scene.CreateEntity(allComponents);
+    Entity crossing = scene.CreateEntity(allComponents);
+    CHECK(scene.GetTransform(crossing) == secondChunkStart);
+
+    // emptying the chunk in front of a spare releases the older spare and leaves nothing to iterate
+    scene.DestroyEntity(crossing);
+    scene.DestroyEntity(refill);
+    for(size_t i = 0; i < CHUNK_CAPACITY; i++)
+    {
+        scene.DestroyEntity(entities[i]);
+    }
+    CHECK(scene.GetEntityCount() == 0);
+    counts.clear();
+    scene.ForEachChunk(ComponentTransform, [&counts](Chunk& chunk) { counts.push_back(chunk.count); });
+    CHECK(counts.empty());
+
+    Entity reborn = scene.CreateEntity(allComponents);
+    CHECK(scene.GetTransform(reborn) != nullptr && scene.GetTransform(reborn)->position == glm::vec3(0.0f));
+}
+
+static void TestGenerations()
+{
+    Scene scene;
+    Entity first = scene.CreateEntity(ComponentTransform);
+    scene.DestroyEntity(first);
+
+    Entity second = scene.CreateEntity(ComponentTransform);
+    CHECK(second.index == first.index);
+    CHECK(second.generation != first.generation);
+    CHECK(!scene.IsAlive(first));
+    CHECK(scene.IsAlive(second));
+    CHECK(scene.GetTransform(first) == nullptr);
+
+    // destroying through a stale handle must not touch the new occupant
+    scene.DestroyEntity(first);
+    CHECK(scene.IsAlive(second));
+    CHECK(scene.GetEntityCount() == 1);
+}
+
+static void TestSystems(ThreadPool& threadPool)
+{
+    Scene scene;
+
+    Entity inFront = scene.CreateEntity(allComponents);
+    scene.GetTransform(inFront)->position = glm::vec3(0.0f, 0.0f, -5.0f);
+    scene.GetAnimation(inFront)->angularSpeed = 10.0f;
+    scene.GetAnimation(inFront)->phase = 5.0f;
+    scene.GetBounds(inFront)->radius = 1.0f;
+
+    Entity behind = scene.CreateEntity(allComponents);
+    scene.GetTransform(behind)->position = glm::vec3(0.0f, 0.0f, 5.0f);
+    scene.GetBounds(behind)->radius = 1.0f;
+
+    UpdateAnimationSystem(scene, threadPool, 2.0f);
+    CHECK(scene.GetTransform(inFront)->rotationAngle == 25.0f);
+
+    UpdateTransformSystem(scene, threadPool);
+    CHECK(glm::vec3(scene.GetTransform(behind)->model[3]) == glm::vec3(0.0f, 0.0f, 5.0f));
+
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 proj = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+    UpdateCullSystem(scene, threadPool, proj * view);
+
+    CHECK(scene.GetRenderable(inFront)->visible);
+    CHECK(!scene.GetRenderable(behind)->visible);
+}
+
+int main()
+{
+    ThreadPool threadPool;
+    threadPool.Create();
+
+    TestCreateAndDefaults();
+    TestDestroyFillsHoleWithLastEntity();
+    TestGenerations();
+    TestSystems(threadPool);
+
+    threadPool.Dispose();
+    return TestResult();
+}
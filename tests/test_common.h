@@ -0,0 +1,46 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// Minimal check macro for the headless tests. Unlike assert it stays active in release builds and keeps going after a failure
+static int failedChecks = 0;
+
+#define CHECK(condition)                                                                            \
+    do                                                                                              \
+    {                                                                                               \
+        if(!(condition))                                                                            \
+        {                                                                                           \
+            std::cout << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed" << std::endl; \
+            failedChecks++;                                                                         \
+        }                                                                                           \
+    } while(false)
+
+// tolerance is absolute up to magnitude 1 and relative above that
+inline bool IsNear(double lhs, double rhs, double tolerance)
+{
+    return std::abs(lhs - rhs) <= tolerance * std::max(1.0, std::abs(rhs));
+}
+
+inline bool IsNear(const glm::vec3& lhs, const glm::vec3& rhs, double tolerance)
+{
+    return IsNear(lhs.x, rhs.x, tolerance) && IsNear(lhs.y, rhs.y, tolerance) && IsNear(lhs.z, rhs.z, tolerance);
+}
+
+// returned by tests that cannot run on this machine, registered as SKIP_RETURN_CODE so CTest reports them as skipped
+static const int TEST_SKIPPED = 77;
+
+static int TestResult()
+{
+    if(failedChecks != 0)
+    {
+        std::cout << failedChecks << " check(s) failed" << std::endl;
+        return 1;
+    }
+
+    std::cout << "all checks passed" << std::endl;
+    return 0;
+}